@@ -1,10 +1,12 @@
 #pragma once
 
+#include <libnes/cpu_interrupts.hpp>
 #include <libnes/literals.hpp>
 #include <libnes/ppu_name_table.hpp>
 
 #include <cstdint>
 #include <optional>
+#include <span>
 #include <vector>
 
 namespace nes
@@ -34,14 +36,47 @@ public:
 
     [[nodiscard]] virtual auto mirroring() const noexcept -> name_table_mirroring = 0;
 
+    // write returns true when the write may have changed the memory map
+    // (a bank switch), so the bus knows to ask for its pages again
     virtual auto write(std::uint16_t addr, std::uint8_t value) -> bool = 0;
     [[nodiscard]] virtual auto read(std::uint16_t addr) -> std::optional<std::uint8_t> = 0;
 
+    // The 256 bytes of CPU page `page` ($xx00-$xxFF) as currently mapped,
+    // for the bus to access directly; nullptr where accesses have to go
+    // through read/write instead
+    [[nodiscard]] virtual auto read_page([[maybe_unused]] std::uint8_t page) -> const std::uint8_t* { return nullptr; }
+    [[nodiscard]] virtual auto write_page([[maybe_unused]] std::uint8_t page) -> std::uint8_t* { return nullptr; }
+
     // addr is a PPU pattern-table address, 0x0000-0x1FFF; the mapper resolves
     // it to a CHR bank. Writes are ignored by boards with CHR ROM, matching
     // real hardware; boards with CHR RAM store into it.
     [[nodiscard]] virtual auto chr_read(std::uint16_t addr) const noexcept -> std::uint8_t = 0;
     virtual void chr_write(std::uint16_t addr, std::uint8_t value) noexcept = 0;
+
+    // The pixels of a tile's row, decoded from the two planes at addr and
+    // addr + 8 (see chr_tile_cache) as the bank mapped there has them now
+    [[nodiscard]] virtual auto chr_row(std::uint16_t addr) const noexcept -> std::span<const std::uint8_t, 8> = 0;
+
+    // Where the board's IRQ goes. Boards with an IRQ counter, like the
+    // MMC3, hold and release it through irq()
+    void connect(interrupt_lines* lines) noexcept { interrupts_ = lines; }
+
+    // The CPU cycle the next write lands on, told by the bus before each.
+    // Boards that care how close together writes come, like the MMC1,
+    // read it back through write_cycle()
+    void set_write_cycle(std::uint64_t cycle) noexcept { write_cycle_ = cycle; }
+
+protected:
+    void irq(bool asserted) noexcept {
+        if (interrupts_ != nullptr)
+            interrupts_->set_irq(irq_source::mapper, asserted);
+    }
+
+    [[nodiscard]] auto write_cycle() const noexcept { return write_cycle_; }
+
+private:
+    interrupt_lines* interrupts_{nullptr};
+    std::uint64_t write_cycle_{0};
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <libnes/literals.hpp>
+#include <libnes/simd.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace nes
+{
+
+// A row of a tile as the PPU draws it: 8 pixels, leftmost first, each
+// its 2-bit color index from the two bit planes
+[[nodiscard]] constexpr auto decode_tile_row(std::uint8_t plane_lo, std::uint8_t plane_hi) noexcept {
+    auto row = std::array<std::uint8_t, 8>{};
+    for (auto x = 0; x < 8; ++x) {
+        auto bit = 7 - x;
+        row[x] = static_cast<std::uint8_t>(((plane_lo >> bit) & 0x01) | (((plane_hi >> bit) & 0x01) << 1));
+    }
+    return row;
+}
+
+// All 8 rows of a tile, from its 16 bytes: the 8 of the low plane, then
+// the 8 of the high one. With SSE2 two rows are decoded at a time, each
+// plane byte repeated across its row's 8 lanes and tested against the
+// lane's bit
+[[nodiscard]] inline auto decode_tile(std::span<const std::uint8_t, 16> planes) noexcept {
+    auto pixels = std::array<std::uint8_t, 64>{};
+
+#if LIBNES_SSE2
+    auto spread = [](std::uint8_t first, std::uint8_t second) {
+        auto v = _mm_cvtsi32_si128(first | (second << 8));
+        v = _mm_unpacklo_epi8(v, v);
+        v = _mm_unpacklo_epi16(v, v);
+        return _mm_unpacklo_epi32(v, v);
+    };
+    auto set = [](__m128i plane, __m128i bits) { return _mm_cmpeq_epi8(_mm_and_si128(plane, bits), bits); };
+
+    const auto bits = _mm_set1_epi64x(0x0102'0408'1020'4080);// bit 7 in the leftmost lane
+    for (auto row = 0; row < 8; row += 2) {
+        auto lo = set(spread(planes[row], planes[row + 1]), bits);
+        auto hi = set(spread(planes[row + 8], planes[row + 9]), bits);
+        auto row_pixels = _mm_or_si128(_mm_and_si128(lo, _mm_set1_epi8(1)), _mm_and_si128(hi, _mm_set1_epi8(2)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels.data() + row * 8), row_pixels);
+    }
+#else
+    for (auto row = 0; row < 8; ++row)
+        std::ranges::copy(decode_tile_row(planes[row], planes[row + 8]), pixels.begin() + row * 8);
+#endif
+
+    return pixels;
+}
+
+// The 256 tiles of a 4Kb CHR bank, decoded row by row. A mapper keeps one
+// per physical bank, so switching banks costs nothing, and boards with
+// CHR RAM decode again the row a write lands in
+class chr_tile_cache
+{
+public:
+    constexpr chr_tile_cache() = default;
+
+    explicit chr_tile_cache(std::span<const std::uint8_t, 4_Kb> chr) noexcept {
+        for (auto offset = std::size_t{0}; offset < chr.size(); offset += 16)
+            std::ranges::copy(decode_tile(chr.subspan(offset).first<16>()), pixels_.begin() + static_cast<std::ptrdiff_t>(index(offset)));
+    }
+
+    // offset is where in the bank a byte was written, in either plane
+    constexpr void update(std::span<const std::uint8_t, 4_Kb> chr, std::uint16_t offset) noexcept {
+        decode(chr, offset & 0x0FF7u);
+    }
+
+    // offset is that of the row's low plane byte: tile * 16 + row
+    [[nodiscard]] constexpr auto row(std::uint16_t offset) const noexcept -> std::span<const std::uint8_t, 8> {
+        return std::span<const std::uint8_t, 8>{pixels_.data() + index(offset), 8};
+    }
+
+private:
+    [[nodiscard]] constexpr static auto index(std::size_t offset) noexcept -> std::size_t {
+        return ((offset & 0x0FF0u) / 2 + (offset & 0x07u)) * 8;
+    }
+
+    constexpr void decode(std::span<const std::uint8_t, 4_Kb> chr, std::size_t offset) noexcept {
+        auto row = decode_tile_row(chr[offset], chr[offset + 8]);
+        std::ranges::copy(row, pixels_.begin() + static_cast<std::ptrdiff_t>(index(offset)));
+    }
+
+    std::array<std::uint8_t, 256 * 8 * 8> pixels_{};
+};
+
+}// namespace nes
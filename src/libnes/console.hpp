@@ -5,83 +5,189 @@
 #include <libnes/mappers/mmc1.hpp>
 #include <libnes/mappers/nrom.hpp>
 #include <libnes/ppu.hpp>
+
+#include <functional>
 #include <memory>
+#include <variant>
 
 namespace nes
 {
 
-template <typename T>
-concept PPU = requires(T t, std::uint16_t address, std::uint8_t value, nes::cartridge* rom, nes::name_table_mirroring m) {
+template <typename T, typename cartridge_t = nes::cartridge>
+concept PPU = requires(T t, std::uint16_t address, std::uint8_t value, cartridge_t* rom, nes::name_table_mirroring m, interrupt_lines* lines) {
     { t.read(address) } -> std::same_as<std::optional<std::uint8_t>>;
     { t.dma_write(address, std::invocable<std::uint16_t>) };
     { t.load_cartridge(rom) };
     { t.eject_cartridge() };
+    { t.connect(lines) };
 };
 
-template <PPU P>
+// cartridge_t is the static type the bus talks to the cartridge through;
+// with a final mapper class the PRG reads and writes are direct calls
+template <typename P, typename cartridge_t = nes::cartridge>
+    requires PPU<P, cartridge_t>
 struct console_bus {
     struct controller_hack {
         std::uint8_t keys{0};
         std::uint8_t snapshot{0};
     } j1;
 
-    explicit constexpr console_bus(P& ppu, cartridge* cartridge = nullptr)
+    explicit constexpr console_bus(P& ppu, cartridge_t* cartridge = nullptr)
         : ppu_{ppu} {
 
+        // $0000-$1FFF: the 2Kb of internal RAM, mirrored four times
+        for (auto page = 0x00; page < 0x20; ++page)
+            read_map_[page] = write_map_[page] = mem.data() + (page % 8) * 0x100;
+
+        ppu.connect(&interrupts_);
         load_cartridge(cartridge);
     }
 
+    // The memory map points into mem
+    console_bus(const console_bus&) = delete;
+    console_bus& operator=(const console_bus&) = delete;
+
     constexpr auto ppu() -> auto& {
         return ppu_.get();
     }
 
-    constexpr void load_cartridge(cartridge* new_cartridge) {
+    constexpr void load_cartridge(cartridge_t* new_cartridge) {
         cartridge_ = new_cartridge;
+        if (cartridge_ != nullptr)
+            cartridge_->connect(&interrupts_);
+        map_cartridge();
 
         ppu().load_cartridge(cartridge_);
     }
 
     constexpr void eject_cartridge() {
         ppu().eject_cartridge();
+        if (cartridge_ != nullptr)
+            cartridge_->connect(nullptr);
+        interrupts_.set_irq(irq_source::mapper, false);
         cartridge_ = nullptr;
+        map_cartridge();
     }
 
-    [[nodiscard]] constexpr auto nmi() {
-        if (not ppu().nmi_raised)
-            return false;
+    // Catch-up scheduling: the CPU reports the cycles it runs through with
+    // advance(), and the PPU is brought up to date, through the catch_up
+    // hook, only right before the CPU observes it
+    using catch_up_callback = std::function<void(std::uint64_t cycle)>;
+    catch_up_callback catch_up;
+
+    // The PPU can't raise an NMI before this cycle without a register
+    // access, so checking the interrupt lines until then needs no catching up
+    std::uint64_t nmi_cycle{0};
+
+    // Nor can the PPU status register change before this one, vblank edges
+    // included
+    std::uint64_t status_cycle{0};
+
+    constexpr void advance(int cycles) noexcept { cycle_ += cycles; }
+    [[nodiscard]] constexpr auto cycle() const noexcept { return cycle_; }
 
-        auto nmi_signal = ppu().nmi_raised and not ppu().nmi_seen;
-        ppu().nmi_seen = true;
+    // The PPU, the cartridge, and once there is one the APU, raise their
+    // interrupts here as they happen
+    [[nodiscard]] constexpr auto interrupts() -> interrupt_lines& {
+        if (cycle_ >= nmi_cycle)
+            sync_ppu();
 
-        return nmi_signal;
+        return interrupts_;
+    }
+
+    // Until then a loop polling the status register or memory sees the same
+    // thing on every read, and no interrupt
+    [[nodiscard]] constexpr auto idle_until() -> std::uint64_t {
+        sync_ppu();
+        return status_cycle;
+    }
+
+    // RAM, the PPU status register and directly mapped cartridge memory
+    // read the same twice in a row; other registers may shift or latch
+    [[nodiscard]] constexpr auto is_pollable(std::uint16_t addr) const noexcept -> bool {
+        return addr < 0x2000 or (addr < 0x4000 and (addr & 0x0007) == 2) or read_map_[addr >> 8] != nullptr;
     }
 
     constexpr void write(std::uint16_t addr, std::uint8_t value) {
-        if (addr < 0x2000) {
-            mem[addr % 0x0800] = value;
+        if (auto page = write_map_[addr >> 8]; page != nullptr) {
+            page[addr & 0xFF] = value;
+            return;
+        }
+
+        write_unmapped(addr, value);
+    }
+
+    constexpr std::uint8_t read(std::uint16_t addr) {
+        if (auto page = read_map_[addr >> 8]; page != nullptr)
+            return page[addr & 0xFF];
+
+        return read_unmapped(addr);
+    }
+
+    [[nodiscard]] constexpr auto cartridge() noexcept { return cartridge_; }
+
+    // What the page reads from, when it's plain memory
+    [[nodiscard]] constexpr auto mapped_page(std::uint8_t page) const noexcept -> const std::uint8_t* {
+        return read_map_[page];
+    }
+
+    // Read-only pages -- the cartridge's PRG ROM, as mapped now. Exposing
+    // them lets the CPU predecode the code there
+    [[nodiscard]] constexpr auto code_page(std::uint8_t page) const noexcept -> const std::uint8_t* {
+        return write_map_[page] == nullptr ? read_map_[page] : nullptr;
+    }
+
+    // The zero page and the stack are at the start of the internal RAM
+    [[nodiscard]] constexpr auto ram() noexcept -> std::uint8_t* { return mem.data(); }
+
+    std::array<std::uint8_t, 2_Kb> mem{};
+
+private:
+    constexpr void sync_ppu() {
+        if (catch_up)
+            catch_up(cycle_);
+    }
+
+    // $4100-$FFFF: whatever the cartridge maps there directly. $4000-$40FF
+    // holds the APU and I/O registers, and always goes through the handlers
+    constexpr void map_cartridge() {
+        for (auto page = 0x41; page < 0x100; ++page) {
+            read_map_[page] = cartridge_ != nullptr ? cartridge_->read_page(static_cast<std::uint8_t>(page)) : nullptr;
+            write_map_[page] = cartridge_ != nullptr ? cartridge_->write_page(static_cast<std::uint8_t>(page)) : nullptr;
+        }
+    }
 
-        } else if (addr >= 0x2000 and addr < 0x4000) {
+    constexpr void write_unmapped(std::uint16_t addr, std::uint8_t value) {
+        if (addr >= 0x2000 and addr < 0x4000) {
             // $2008-$3FFF mirrors the eight PPU registers at $2000-$2007
+            sync_ppu();
             ppu().write(static_cast<std::uint16_t>(0x2000 | (addr & 0x0007)), value);
 
         } else if (addr == 0x4014) {
+            sync_ppu();
             ppu().dma_write(value << 8U, [this](auto addr) { return read(addr); });
 
         } else if (addr == 0x4016) {
             j1.snapshot = j1.keys;
         }
 
-        if (cartridge_ != nullptr)
-            cartridge_->write(addr, value);
-    }
+        if (cartridge_ == nullptr)
+            return;
 
-    constexpr std::uint8_t read(std::uint16_t addr) {
-        if (addr <= 0x1FFF) {
-            return mem[addr & 0x07FF];
-        }
+        // A bank switch or a change of mirroring takes effect on the dot
+        // the write lands on, so the PPU has to be drawn up to it first
+        if (addr >= 0x4020)
+            sync_ppu();
+
+        cartridge_->set_write_cycle(cycle_);
+        if (cartridge_->write(addr, value))
+            map_cartridge();
+    }
 
-        if (addr < 0x4000) {
+    constexpr auto read_unmapped(std::uint16_t addr) -> std::uint8_t {
+        if (addr >= 0x2000 and addr < 0x4000) {
             // $2008-$3FFF mirrors the eight PPU registers at $2000-$2007
+            sync_ppu();
             if (auto r = ppu().read(static_cast<std::uint16_t>(0x2000 | (addr & 0x0007))); r.has_value())
                 return r.value();
             return 0;
@@ -97,59 +203,56 @@ struct console_bus {
             return 0;
         }
 
-        if (auto r = cartridge_->read(addr); r.has_value())
-            return r.value();
+        if (cartridge_ != nullptr) {
+            if (auto r = cartridge_->read(addr); r.has_value())
+                return r.value();
+        }
 
         return 0;
     }
 
-    [[nodiscard]] constexpr auto cartridge() noexcept { return cartridge_; }
+    // One entry per 256-byte CPU page: a direct pointer where the page is
+    // plain memory, nullptr where accesses go through the handlers
+    std::array<const std::uint8_t*, 0x100> read_map_{};
+    std::array<std::uint8_t*, 0x100> write_map_{};
 
-    std::array<std::uint8_t, 2_Kb> mem{};
-
-private:
-    nes::cartridge* cartridge_{nullptr};
+    cartridge_t* cartridge_{nullptr};
     std::reference_wrapper<P> ppu_;
+    interrupt_lines interrupts_;
+    std::uint64_t cycle_{0};
 };
 
-class cpu_clock
-{
-public:
-    auto is_cpu_cycle() {
-        return counter_ == 0;
-    }
-
-    void tick() {
-        counter_ = (counter_ + 1) % 3;
-    }
-
-private:
-    int counter_{0};
-};
-
-class console
+// The console wired up for one mapper type: the bus and the PPU hold a
+// mapper_t*, so every mapper call in the hot loops is resolved at compile
+// time
+template <class mapper_t>
+class basic_console
 {
 public:
-    using bus = console_bus<ppu>;
+    using ppu = basic_ppu<mapper_t>;
+    using bus = console_bus<ppu, mapper_t>;
     using cpu = nes::cpu<bus>;
 
-    explicit console(std::unique_ptr<cartridge> rom)
+    explicit basic_console(std::unique_ptr<mapper_t> rom)
         : cartridge_{std::move(rom)}
         , bus_{ppu_, cartridge_.get()} {
     }
 
     template <screen screen_t>
     void render_frame(screen_t& screen) {
-        // The frame is 89342 dots, which is not divisible by 3, so the CPU/PPU
-        // phase must carry across frame boundaries
-        for (;;) {
-            if (cpu_clock_.is_cpu_cycle())
-                cpu_.tick();
-
-            cpu_clock_.tick();
-            ppu_.tick_old(screen);
-            if (ppu_.is_frame_ready()) break;
-        }
+        // The CPU runs ahead on its own clock, whole instructions at a time,
+        // and the PPU only catches up when the CPU is about to observe it,
+        // and once more at the end of the frame. A CPU cycle is three dots;
+        // the frame is 89342 dots, which is not divisible by 3, so the
+        // CPU/PPU phase carries across frame boundaries
+        frame_end_ += ppu_.frame_dots();
+        bus_.catch_up = [this, &screen](auto cycle) { catch_up(screen, cycle * 3); };
+
+        while (bus_.cycle() * 3 < frame_end_)
+            cpu_.run(static_cast<int>((frame_end_ - bus_.cycle() * 3 + 2) / 3));
+
+        catch_up(screen, frame_end_);
+        bus_.catch_up = nullptr;
     }
 
     template <screen screen_t>
@@ -165,6 +268,29 @@ public:
         bus_.j1.keys = keys;
     }
 
+    // Fast-forwards through loops waiting on the PPU; see cpu::skip_idle_loops
+    void skip_idle_loops(bool enabled) noexcept {
+        cpu_.skip_idle_loops(enabled);
+    }
+
+    // Records the instructions the game runs; see cpu::trace
+    void trace(trace_recorder* recorder) noexcept {
+        cpu_.trace(recorder);
+    }
+
+    // Draws the background through the PPU's fetch pipeline, a dot at a
+    // time, rather than looking each tile up; see basic_ppu::tick. Off by
+    // default
+    void pipelined_rendering(bool enabled) noexcept {
+        pipelined_rendering_ = enabled;
+    }
+
+#ifdef LIBNES_PROFILE
+    // Where the game's code spends its time; see cpu::profile
+    [[nodiscard]] auto profile() const noexcept -> const cpu_profile& { return cpu_.profile(); }
+    void clear_profile() noexcept { cpu_.clear_profile(); }
+#endif
+
     // Debug/test-only: read a byte off the CPU-visible bus without advancing
     // emulation. Used to inspect cartridge PRG-RAM (e.g. blargg test ROMs'
     // $6000/$6004 status-and-text convention).
@@ -173,11 +299,109 @@ public:
     }
 
 private:
-    std::unique_ptr<cartridge> cartridge_;
+    // Runs the PPU through every dot before `dot`
+    template <screen screen_t>
+    void catch_up(screen_t& screen, std::uint64_t dot) {
+        if (pipelined_rendering_) {
+            for (; dot_ < dot; ++dot_)
+                ppu_.tick(screen);
+        } else {
+            while (dot_ < dot)
+                dot_ += static_cast<std::uint64_t>(ppu_.run_old(screen, dot - dot_));
+        }
+
+        // A poll at CPU cycle n sees the dots before 3n
+        bus_.nmi_cycle = (dot_ + ppu_.dots_until_vblank_edge()) / 3 + 1;
+        bus_.status_cycle = (dot_ + ppu_.dots_until_status_change()) / 3 + 1;
+    }
+
+    std::unique_ptr<mapper_t> cartridge_;
     ppu ppu_{nes::DEFAULT_COLORS};
     bus bus_{ppu_};
     cpu cpu_{bus_};
-    cpu_clock cpu_clock_;// dot position within the current CPU cycle, carried across frames
+
+    std::uint64_t dot_{0};      // PPU dots run so far
+    std::uint64_t frame_end_{0};// dot the current frame ends at
+
+    bool pipelined_rendering_{false};
+};
+
+// Picks the basic_console for the cartridge's mapper once, when the ROM is
+// loaded. Mappers without a specialization run through the virtual
+// cartridge interface
+class console
+{
+public:
+    explicit console(std::unique_ptr<cartridge> rom)
+        : console_{load(std::move(rom))} {
+    }
+
+    template <screen screen_t>
+    void render_frame(screen_t& screen) {
+        std::visit([&screen](auto& c) { c.render_frame(screen); }, console_);
+    }
+
+    template <screen screen_t>
+    void render_nametables(screen_t& screen) {
+        std::visit([&screen](auto& c) { c.render_nametables(screen); }, console_);
+    }
+
+    auto display_pattern_table(auto i) const {
+        return std::visit([i](const auto& c) { return c.display_pattern_table(i); }, console_);
+    }
+
+    void controller_input(std::uint8_t keys) {
+        std::visit([keys](auto& c) { c.controller_input(keys); }, console_);
+    }
+
+    void skip_idle_loops(bool enabled) noexcept {
+        std::visit([enabled](auto& c) { c.skip_idle_loops(enabled); }, console_);
+    }
+
+    void trace(trace_recorder* recorder) noexcept {
+        std::visit([recorder](auto& c) { c.trace(recorder); }, console_);
+    }
+
+    void pipelined_rendering(bool enabled) noexcept {
+        std::visit([enabled](auto& c) { c.pipelined_rendering(enabled); }, console_);
+    }
+
+#ifdef LIBNES_PROFILE
+    [[nodiscard]] auto profile() const noexcept -> const cpu_profile& {
+        return std::visit([](const auto& c) -> const cpu_profile& { return c.profile(); }, console_);
+    }
+
+    void clear_profile() noexcept {
+        std::visit([](auto& c) { c.clear_profile(); }, console_);
+    }
+#endif
+
+    // Debug/test-only, see basic_console::peek
+    [[nodiscard]] auto peek(std::uint16_t addr) -> std::uint8_t {
+        return std::visit([addr](auto& c) { return c.peek(addr); }, console_);
+    }
+
+private:
+    // The alternatives can't be moved (the bus and the CPU keep references
+    // into the console), so each one is built in place
+    using any_console = std::variant<basic_console<nrom>, basic_console<mmc1>, basic_console<cartridge>>;
+
+    static auto load(std::unique_ptr<cartridge> rom) -> any_console {
+        if (dynamic_cast<nrom*>(rom.get()) != nullptr)
+            return any_console{std::in_place_type<basic_console<nrom>>, downcast<nrom>(std::move(rom))};
+
+        if (dynamic_cast<mmc1*>(rom.get()) != nullptr)
+            return any_console{std::in_place_type<basic_console<mmc1>>, downcast<mmc1>(std::move(rom))};
+
+        return any_console{std::in_place_type<basic_console<cartridge>>, std::move(rom)};
+    }
+
+    template <class mapper_t>
+    static auto downcast(std::unique_ptr<cartridge> rom) -> std::unique_ptr<mapper_t> {
+        return std::unique_ptr<mapper_t>{static_cast<mapper_t*>(rom.release())};
+    }
+
+    any_console console_;
 };
 
 }// namespace nes
\ No newline at end of file
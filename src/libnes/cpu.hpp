@@ -1,25 +1,93 @@
 #pragma once
 
 #include <libnes/cpu_address_modes.hpp>
+#include <libnes/cpu_interrupts.hpp>
+#include <libnes/cpu_opcodes.hpp>
 #include <libnes/cpu_operations.hpp>
 #include <libnes/cpu_registers.hpp>
+#include <libnes/cpu_trace.hpp>
 
+#ifdef LIBNES_PROFILE
+#include <libnes/cpu_profile.hpp>
+#endif
+
+#include <algorithm>
+#include <array>
 #include <concepts>
 #include <cstdint>
-#include <functional>
+#include <initializer_list>
 #include <optional>
 #include <stdexcept>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace nes
 {
 
+// A bus wired to the CPU's interrupt lines, brought up to date with every
+// source that drives them as they're asked for
+template <class B>
+concept interrupt_bus = requires(B b) {
+    { b.interrupts() } -> std::same_as<interrupt_lines&>;
+};
+
+// A bus that has nothing but an NMI line hands it over with nmi(), which
+// the CPU polls and takes as a request
 template <class B>
 concept bus = requires(B b, std::uint16_t address, std::uint8_t value) {
     { b.write(address, value) };
     { b.read(address) } -> std::same_as<std::uint8_t>;
+} and (interrupt_bus<B> or requires(B b) {
     { b.nmi() } -> std::same_as<bool>;
+});
+
+// A bus that keeps time: the CPU reports every cycle it runs through, so
+// the bus knows when each access happens
+template <class B>
+concept clocked_bus = bus<B> and requires(B b, int cycles) {
+    { b.advance(cycles) };
+};
+
+// A bus that exposes the host memory behind read-only pages, whose contents
+// only change by remapping the page. Code there can be decoded once and
+// reused for as long as the page stays mapped
+template <class B>
+concept code_bus = bus<B> and requires(B b, std::uint8_t page) {
+    { b.code_page(page) } -> std::same_as<const std::uint8_t*>;
+};
+
+// A clocked bus that knows how long a loop polling it can go on seeing the
+// same: until idle_until(), reads of the addresses it calls pollable return
+// the same values and the interrupt lines stay put, unless the CPU writes
+template <class B>
+concept idle_bus = clocked_bus<B> and requires(B b, std::uint16_t address) {
+    { b.cycle() } -> std::convertible_to<std::uint64_t>;
+    { b.idle_until() } -> std::convertible_to<std::uint64_t>;
+    { b.is_pollable(address) } -> std::same_as<bool>;
+};
+
+// A bus whose zero page and stack, $0000-$01FF, are plain RAM it hands out.
+// Nothing but that RAM can answer there, so the CPU reads and writes it
+// directly, without the bus decoding the address
+template <class B>
+concept ram_bus = bus<B> and requires(B b) {
+    { b.ram() } -> std::same_as<std::uint8_t*>;
+};
+
+// A bus that says what memory it has mapped at each page, whatever may be
+// accessed there. Profiles tell the banks of code apart by it
+template <class B>
+concept mapped_bus = bus<B> and requires(B b, std::uint8_t page) {
+    { b.mapped_page(page) } -> std::same_as<const std::uint8_t*>;
+};
+
+class unsupported_opcode: public std::runtime_error
+{
+public:
+    explicit unsupported_opcode(std::uint8_t opcode);
 };
 
 template <bus bus_t>
@@ -38,10 +106,17 @@ public:
     arith_register y{p};
 
     struct instruction {
-        instruction(auto operation, auto address_mode, int cycles = 1)
-            : command_{[operation, address_mode](auto& cpu) { return operation(cpu, address_mode(cpu)); }}
-            , c_{cycles} {}
-        instruction() = default;
+        using command = int (*)(cpu&);
+
+        // What interrupt requests have for an opcode
+        static constexpr int INTERRUPT = -1;
+
+        constexpr instruction(command command, int cycles, int length, int opcode)
+            : command_{command}
+            , c_{cycles}
+            , length_{length}
+            , opcode_{opcode} {}
+        constexpr instruction() = default;
 
         void execute(cpu& cpu) {
             if (is_finished())
@@ -55,14 +130,45 @@ public:
             }
         }
 
+        // Runs the whole instruction at once, returning the cycles it takes.
+        // On a bus that keeps time, every access lands on its own cycle: the
+        // opcode fetch was the first, each access the operation makes takes
+        // the next, and the cycles left over once it's done come at the end
+        auto complete(cpu& cpu) -> int {
+            auto cycles = cpu.run_timed(command_, c_);
+
+            c_ = 0;
+            ac_ = 0;
+            return cycles;
+        }
+
         [[nodiscard]] bool is_finished() const noexcept { return c_ == 0 && ac_ == 0; }
 
+        // Bytes the instruction takes in memory, opcode included
+        [[nodiscard]] constexpr auto length() const noexcept { return length_; }
+
+        [[nodiscard]] constexpr auto opcode() const noexcept { return opcode_; }
+
+        // How far tick() has got through it: the cycles left until it takes
+        // effect, and those it goes on taking after
+        [[nodiscard]] constexpr auto cycles_left() const noexcept { return c_; }
+        [[nodiscard]] constexpr auto additional_cycles_left() const noexcept { return ac_; }
+
+        void resume(int cycles_left, int additional_cycles_left) noexcept {
+            c_ = cycles_left;
+            ac_ = additional_cycles_left;
+        }
+
     private:
-        std::function<int(cpu&)> command_;
+        command command_{nullptr};
         int c_{0};
         int ac_{0};
+        int length_{1};
+        int opcode_{0};
     };
 
+    // The registers, and how far tick() has got through the instruction in
+    // progress, as plain data: states copy, compare and hash byte for byte
     struct state {
         std::uint16_t pc;
 
@@ -73,46 +179,432 @@ public:
         std::uint8_t x;
         std::uint8_t y;
 
-        instruction cix;
+        std::uint8_t opcode;// of the instruction in progress
+        bool interrupt;// in progress rather than the opcode
+        std::uint8_t cycles_left;// both 0 when nothing is in progress
+        std::uint8_t additional_cycles_left;
+        std::uint8_t reserved{0};
     };
 
+    static_assert(std::is_trivially_copyable_v<state>);
+    static_assert(std::has_unique_object_representations_v<state>);
+
 
     void tick();
+    auto step() -> int;
+    auto run(int cycles) -> int;
     auto is_executing() { return !current_instruction.is_finished(); }
 
-    void write(std::uint16_t addr, std::uint8_t value) const { bus_.write(addr, value); }
+    void write(std::uint16_t addr, std::uint8_t value) {
+        bus_.write(addr, value);
+        next_cycle();
+    }
+
+    [[nodiscard]] auto read(std::uint16_t addr) {
+        auto value = bus_.read(addr);
+        next_cycle();
+        return value;
+    }
+
+    // Zero page and stack accesses, timed like any other
+    [[nodiscard]] auto read_zero_page(std::uint8_t addr) { return read_ram(addr); }
+    void write_zero_page(std::uint8_t addr, std::uint8_t value) { write_ram(addr, value); }
+    [[nodiscard]] auto read_zero_page_word(std::uint8_t addr) -> std::uint16_t;
+
+    void push(std::uint8_t value) { write_ram(s.push(), value); }
+    [[nodiscard]] auto pop() { return read_ram(s.pop()); }
+
+    [[nodiscard]] auto read_signed(std::uint16_t addr) { return static_cast<std::int8_t>(read(addr)); }
+    [[nodiscard]] auto read_word(std::uint16_t addr) -> std::uint16_t;
+    [[nodiscard]] auto read_word_wrapped(std::uint16_t addr) -> std::uint16_t;
+
+    // The cycles an instruction spends on accesses whose result it throws
+    // away. They are only timed, and only made, while complete() runs an
+    // instruction on a bus that keeps time; dummy reads are only made where
+    // they may be seen, code and the stack being plain memory
+    void idle_cycle() { next_cycle(); }
+
+    void dummy_read(std::uint16_t addr) {
+        if (is_timing()) {
+            static_cast<void>(bus_.read(addr));
+            next_cycle();
+        }
+    }
+
+    void dummy_write(std::uint16_t addr, std::uint8_t value) {
+        if (is_timing())
+            write(addr, value);
+    }
+
+    void dummy_write_zero_page(std::uint8_t addr, std::uint8_t value) {
+        if (is_timing())
+            write_zero_page(addr, value);
+    }
 
-    [[nodiscard]] auto read(std::uint16_t addr) const { return bus_.read(addr); }
-    [[nodiscard]] auto read_signed(std::uint16_t addr) const { return static_cast<std::int8_t>(read(addr)); }
-    [[nodiscard]] auto read_word(std::uint16_t addr) const -> std::uint16_t;
-    [[nodiscard]] auto read_word_wrapped(std::uint16_t addr) const -> std::uint16_t;
+    // The operand bytes following the opcode, taken from the predecoded
+    // instruction when there is one, and read off the bus otherwise
+    [[nodiscard]] auto fetch_operand() -> std::uint8_t;
+    [[nodiscard]] auto fetch_operand_word() -> std::uint16_t;
 
     auto decode(std::uint8_t opcode) -> instruction;
 
     auto interrupt() -> int;
 
+    // Whether to take an interrupt rather than the next instruction: an NMI,
+    // or an IRQ the I flag doesn't mask
+    [[nodiscard]] auto interrupt_pending() -> bool {
+        if constexpr (interrupt_bus<bus_t>)
+            return bus_.interrupts().pending(p.test(cpu_flag::int_disable));
+        else
+            return bus_.nmi();
+    }
+
+    // BRK, IRQ and NMI pick their vector only once they've pushed
+    // everything, as they fetch it: an NMI latched by then takes over
+    // whichever started, which then runs the NMI handler
+    [[nodiscard]] auto interrupt_vector(std::uint16_t vector) -> std::uint16_t {
+        if constexpr (interrupt_bus<bus_t>) {
+            if (bus_.interrupts().acknowledge_nmi())
+                return NMI_VECTOR;
+        }
+        return vector;
+    }
+
+    static constexpr std::uint16_t NMI_VECTOR = 0xFFFA;
+    static constexpr std::uint16_t IRQ_VECTOR = 0xFFFE;
+
     [[nodiscard]] auto save_state() const -> state;
     void load_state(state state);
 
+    // Lets run() fast-forward through loops that do nothing but poll the
+    // bus, up to when what they poll can next change. Only buses that can
+    // tell when that is are fast-forwarded; off by default
+    void skip_idle_loops(bool enabled) noexcept { skip_idle_loops_ = enabled; }
+
+    // Records every instruction step() and run() run from now on, until
+    // given nullptr. Traced instructions run one at a time, rather than
+    // fused or in blocks, which takes them just as many cycles
+    void trace(trace_recorder* recorder) noexcept { tracer_ = recorder; }
+
+    // Drops every predecoded block. Only needed when the memory behind the
+    // code pages is freed or rewritten, e.g. when swapping cartridges
+    void flush_code_cache();
+
+#ifdef LIBNES_PROFILE
+    // The instructions step() and run() have run since the last clear, and
+    // their cycles, interrupts and fast-forwarded idle loops left out
+    [[nodiscard]] auto profile() const noexcept -> const cpu_profile& { return profile_; }
+    void clear_profile() noexcept { profile_.clear(); }
+#endif
+
 
 private:
-    class hasher
-    {
-    public:
-        [[nodiscard]] constexpr auto operator()(std::uint8_t v) const noexcept {
-            return v;
+    // The operations and the address modes behind the mnemonics and the
+    // addressings of the opcode table, in the same order
+    using operations = std::tuple<
+        decltype(adc), decltype(ana), decltype(asl), decltype(bcc), decltype(bcs), decltype(beq), decltype(bit),
+        decltype(bmi), decltype(bne), decltype(bpl), decltype(brk), decltype(bvc), decltype(bvs), decltype(clc),
+        decltype(cld), decltype(cli), decltype(clv), decltype(cmp), decltype(cpx), decltype(cpy), decltype(dcp),
+        decltype(dec), decltype(dex), decltype(dey), decltype(eor), decltype(i_n), decltype(inc), decltype(inx),
+        decltype(iny), decltype(isc), decltype(jmp), decltype(jsr), decltype(lax), decltype(lda), decltype(ldx),
+        decltype(ldy), decltype(lsr), decltype(nop), decltype(ora), decltype(pha), decltype(php), decltype(pla),
+        decltype(plp), decltype(rla), decltype(rol), decltype(ror), decltype(rra), decltype(rti), decltype(rts),
+        decltype(sax), decltype(sbc), decltype(sec), decltype(sed), decltype(sei), decltype(slo), decltype(sre),
+        decltype(sta), decltype(stx), decltype(sty), decltype(tax), decltype(tay), decltype(tsx), decltype(txa),
+        decltype(txs), decltype(tya)>;
+
+    using address_modes = std::tuple<
+        decltype(imp), decltype(acc), decltype(imm), decltype(zp), decltype(zpx), decltype(zpy), decltype(abs),
+        decltype(abx), decltype(aby), decltype(ind), decltype(izx), decltype(izy), decltype(rel)>;
+
+    static_assert(std::tuple_size_v<operations> == static_cast<std::size_t>(mnemonic::tya));
+    static_assert(std::tuple_size_v<address_modes> == static_cast<std::size_t>(addressing::rel) + 1);
+
+    // What the opcode does, as the table describes it. The page crossing
+    // cycle address modes report only counts where the table says so
+    template <std::uint8_t opcode>
+    static auto execute_opcode(cpu& cpu) -> int {
+        constexpr auto info = OPCODES[opcode];
+
+        if constexpr (info.mnemonic == mnemonic::unsupported) {
+            throw unsupported_opcode(opcode);
+        } else {
+            using operation_t = std::remove_cvref_t<std::tuple_element_t<static_cast<std::size_t>(info.mnemonic) - 1, operations>>;
+            using address_mode_t = std::remove_cvref_t<std::tuple_element_t<static_cast<std::size_t>(info.addressing), address_modes>>;
+
+            // Implied operands still take a cycle to read the byte after
+            // the opcode
+            if constexpr (info.addressing == addressing::imp or info.addressing == addressing::acc)
+                cpu.idle_cycle();
+
+            auto additional_cycles = operation_t{}(cpu, address_mode_t{}(cpu, access_constant<info.access>{}));
+            if constexpr (not info.page_penalty)
+                additional_cycles = 0;
+
+            return additional_cycles;
+        }
+    }
+
+    static constexpr auto make_instruction_set() -> std::array<instruction, 256>;
+
+    // Pairs of instructions hot loops are made of. When the second comes
+    // right after the first, the first's handler runs it too, with a direct
+    // call instead of a dispatch. An instruction may start several pairs
+    static constexpr auto FUSED_PAIRS = std::to_array<std::array<std::uint8_t, 2>>({
+        {0xCA, 0xD0},// DEX; BNE
+        {0x88, 0xD0},// DEY; BNE
+        {0xE8, 0xD0},// INX; BNE
+        {0xE8, 0xE0},// INX; CPX #
+        {0xE0, 0xD0},// CPX #; BNE
+        {0xC8, 0xD0},// INY; BNE
+        {0xC8, 0xC0},// INY; CPY #
+        {0xC0, 0xD0},// CPY #; BNE
+        {0xC9, 0xD0},// CMP #; BNE
+        {0xC9, 0xF0},// CMP #; BEQ
+        {0xC6, 0xD0},// DEC zp; BNE
+        {0xA5, 0xD0},// LDA zp; BNE
+        {0xA5, 0xF0},// LDA zp; BEQ
+        {0xAD, 0x10},// LDA abs; BPL -- polling $2002
+        {0xAD, 0x30},// LDA abs; BMI
+        {0x2C, 0x10},// BIT abs; BPL
+        {0x2C, 0x30},// BIT abs; BMI
+        {0x2C, 0x50},// BIT abs; BVC
+        {0x2C, 0x70},// BIT abs; BVS
+        {0xBD, 0x9D},// LDA abs,X; STA abs,X -- copy loops
+        {0x9D, 0xE8},// STA abs,X; INX
+        {0xB9, 0x99},// LDA abs,Y; STA abs,Y
+        {0x99, 0xC8},// STA abs,Y; INY
+        {0xB1, 0x91},// LDA (zp),Y; STA (zp),Y
+        {0x91, 0xC8},// STA (zp),Y; INY
+    });
+
+    // The instructions `opcode` is the first of a pair with
+    struct fused_tails {
+        std::array<std::uint8_t, FUSED_PAIRS.size()> opcodes{};
+        std::size_t count{0};
+    };
+
+    [[nodiscard]] static constexpr auto tails_of(std::uint8_t opcode) noexcept -> fused_tails {
+        auto tails = fused_tails{};
+        for (auto [head, tail]: FUSED_PAIRS) {
+            if (head == opcode)
+                tails.opcodes[tails.count++] = tail;
+        }
+        return tails;
+    }
+
+    // Runs the first instruction of a pair, just fetched, and then the one
+    // after it if there are cycles left and no interrupt comes in between.
+    // Both are timed and polled around exactly as run() would
+    template <std::uint8_t opcode>
+    static auto execute_fused(cpu& cpu, int cycles) -> int;
+
+    using fused_handler = int (*)(cpu&, int cycles);
+    static constexpr auto make_fused_set() -> std::array<fused_handler, 256>;
+
+    // An instruction decoded ahead of time, with the operand bytes that
+    // follow its opcode
+    struct predecoded_instruction {
+        std::uint16_t pc;
+        std::array<std::uint8_t, 2> operand;
+        std::uint8_t opcode;
+        instruction handler;
+    };
+
+    // A straight-line run of instructions, up to the first one that may
+    // change the flow of control or the end of the page. Blocks are keyed
+    // by PC and by the memory mapped there, so a bank switch simply brings
+    // in another set of blocks
+    struct code_block {
+        const std::uint8_t* page;
+        std::uint16_t pc;
+        std::vector<predecoded_instruction> code;
+    };
+
+    struct block_key {
+        const std::uint8_t* page;
+        std::uint16_t pc;
+
+        auto operator==(const block_key&) const -> bool = default;
+    };
+
+    struct block_key_hash {
+        auto operator()(const block_key& key) const noexcept {
+            return std::hash<const std::uint8_t*>{}(key.page) ^ key.pc;
         }
     };
+
+    static constexpr auto interrupt_request() -> instruction {
+        return instruction{[](cpu& cpu) { return cpu.interrupt(); }, 1, 1, instruction::INTERRUPT};
+    }
+
+    [[nodiscard]] static constexpr auto ends_block(std::uint8_t opcode) noexcept -> bool {
+        return changes_flow(OPCODES[opcode].mnemonic);
+    }
+
+    // The loop the CPU last branched back through, and what it was like the
+    // last time round
+    struct idle_loop {
+        std::uint16_t head{0};// the branch target
+        std::uint16_t tail{0};// the branch or jump back
+        bool polls_only{false};
+
+        bool came_round{false};
+        std::uint64_t cycle{0};// when it last came round to the head
+        std::uint64_t until{0};// what it polls stays the same until then
+        std::array<std::uint8_t, 5> registers{};
+    };
+
+    // Polling loops are kept short; longer loops aren't worth scanning
+    static constexpr auto IDLE_LOOP_BYTES = 16;
+
+    // Whether a polling loop may be made of the instruction: it mustn't
+    // write, touch the stack or go anywhere else, and whatever it reads has
+    // to be at a fixed address
+    [[nodiscard]] static constexpr auto may_poll(std::uint8_t opcode) noexcept -> bool {
+        auto info = OPCODES[opcode];
+        if (info.mnemonic == mnemonic::unsupported or uses_stack(info.mnemonic) or info.mnemonic == mnemonic::jmp)
+            return false;
+
+        switch (info.access) {
+            case memory_access::none:
+                return true;
+            case memory_access::read:
+                return info.addressing == addressing::zp or info.addressing == addressing::abs;
+            default:
+                return false;
+        }
+    }
+
+    auto fetch() -> instruction;
+    auto step_polling(int cycles) -> int;
+    auto loop_back(std::uint16_t tail, int cycles) -> int;
+    [[nodiscard]] auto is_polling_loop(std::uint16_t head, std::uint16_t tail) -> bool;
+    auto find_block() -> const code_block*;
+    auto run_block(const code_block& block, int cycles) -> int;
+    auto decode_block(const std::uint8_t* page, std::uint16_t address) -> code_block;
+    auto execute(const predecoded_instruction& code) -> int;
+    auto run_traced() -> int;
+
+    // The byte at `address`, without it being read where that could be
+    // seen: a bus that maps memory is only read where it does
+    [[nodiscard]] auto peek(std::uint16_t address) -> std::uint8_t {
+        if constexpr (mapped_bus<bus_t>) {
+            auto page = bus_.mapped_page(static_cast<std::uint8_t>(address >> 8));
+            return page != nullptr ? page[address & 0xFF] : 0;
+        }
+        else {
+            return bus_.read(address);
+        }
+    }
+
+    // Counts an instruction just run from `address` towards the profile;
+    // nothing unless profiling
+    void count([[maybe_unused]] std::uint16_t address, [[maybe_unused]] std::uint8_t opcode,
+               [[maybe_unused]] int cycles) {
+#ifdef LIBNES_PROFILE
+        auto memory = static_cast<const std::uint8_t*>(nullptr);
+        if constexpr (mapped_bus<bus_t>)
+            memory = bus_.mapped_page(static_cast<std::uint8_t>(address >> 8));
+
+        profile_.record(memory, address, opcode, cycles);
+#endif
+    }
+
+    void elapse(int cycles) {
+        if constexpr (clocked_bus<bus_t>)
+            bus_.advance(cycles);
+    }
+
+    [[nodiscard]] auto is_timing() const noexcept -> bool {
+        if constexpr (clocked_bus<bus_t>)
+            return access_cycle_ != NOT_TIMED;
+        else
+            return false;
+    }
+
+    // Runs the command of an instruction whose opcode was just fetched,
+    // timing its accesses; see instruction::complete()
+    auto run_timed(auto command, int base_cycles) -> int {
+        elapse(1);
+        access_cycle_ = 1;
+
+        // Untimed again however the command leaves, unsupported_opcode
+        // included
+        struct timing_end {
+            int& access_cycle;
+            ~timing_end() { access_cycle = NOT_TIMED; }
+        } end{access_cycle_};
+
+        auto cycles = base_cycles + command(*this);
+
+        elapse(cycles - access_cycle_);
+        return cycles;
+    }
+
+    // The same for an opcode known at compile time, with no dispatch
+    template <std::uint8_t opcode>
+    auto complete_opcode() -> int {
+        return run_timed([](cpu& self) { return execute_opcode<opcode>(self); }, std::max(OPCODES[opcode].cycles, 1));
+    }
+
+    // An address below $0200
+    [[nodiscard]] auto read_ram(std::uint16_t addr) -> std::uint8_t {
+        if constexpr (ram_bus<bus_t>) {
+            auto value = bus_.ram()[addr];
+            next_cycle();
+            return value;
+        }
+        else {
+            return read(addr);
+        }
+    }
+
+    void write_ram(std::uint16_t addr, std::uint8_t value) {
+        if constexpr (ram_bus<bus_t>) {
+            bus_.ram()[addr] = value;
+            next_cycle();
+        }
+        else {
+            write(addr, value);
+        }
+    }
+
+    void next_cycle() {
+        if constexpr (clocked_bus<bus_t>) {
+            if (access_cycle_ != NOT_TIMED) {
+                bus_.advance(1);
+                ++access_cycle_;
+            }
+        }
+    }
+
     bus_t& bus_;
     instruction current_instruction;
-    static const std::unordered_map<std::uint8_t, cpu::instruction, hasher> instruction_set;
-};
 
+    // The cycles of the instruction complete() is running that have gone by
+    static constexpr auto NOT_TIMED = -1;
+    int access_cycle_{NOT_TIMED};
 
-class unsupported_opcode: public std::runtime_error
-{
-public:
-    explicit unsupported_opcode(std::uint8_t opcode);
+    bool skip_idle_loops_{false};
+    idle_loop idle_loop_;
+
+    trace_recorder* tracer_{nullptr};
+    std::uint64_t traced_cycles_{0};// the trace's clock on a bus without one
+
+    std::unordered_map<block_key, code_block, block_key_hash> code_cache_;
+    std::vector<const code_block*> block_at_;// the block last run from each PC
+    const std::uint8_t* operands_{nullptr};
+
+#ifdef LIBNES_PROFILE
+    cpu_profile profile_;
+#endif
+
+    // One entry per opcode, built at compile time; opcodes the CPU doesn't
+    // implement trap with unsupported_opcode when executed
+    static const std::array<instruction, 256> instruction_set;
+    // The handlers of the instructions that start a pair, nullptr elsewhere
+    static const std::array<fused_handler, 256> fused_set;
 };
 
 
@@ -124,24 +616,314 @@ cpu<bus_t>::cpu(bus_t& b)
 
 template <bus bus_t>
 void cpu<bus_t>::tick() {
-    if (current_instruction.is_finished()) {
-        if (not bus_.nmi()) {
+    if (current_instruction.is_finished())
+        current_instruction = fetch();
 
-            auto opcode = read(pc.advance());
-            current_instruction = decode(opcode);
+    current_instruction.execute(*this);
+    elapse(1);
+}
 
-        } else {
-            current_instruction = cpu::instruction{
-                [this](auto...) -> int { return interrupt(); },
-                imp};
+// Executes one whole instruction (or interrupt) and returns the cycles it
+// took. An instruction left half-way through by tick() is finished first,
+// cycle by cycle, and counts as the step.
+template <bus bus_t>
+auto cpu<bus_t>::step() -> int {
+    return run(1);
+}
+
+// Executes whole instructions until at least `cycles` have gone by, and
+// returns the cycles actually run -- the same as calling step() until
+// then. Straight-line code in the bus's code pages is run block by block
+// from the predecoded cache
+template <bus bus_t>
+auto cpu<bus_t>::run(int cycles) -> int {
+    auto elapsed = 0;
+    for (; is_executing(); ++elapsed)
+        tick();
+
+    while (elapsed < cycles) {
+        if (interrupt_pending()) {
+            idle_loop_.came_round = false;
+            elapsed += interrupt_request().complete(*this);
+            continue;
+        }
+
+        if (tracer_ != nullptr) {
+            elapsed += run_traced();
+            continue;
+        }
+
+        if constexpr (idle_bus<bus_t>) {
+            if (skip_idle_loops_) {
+                elapsed += step_polling(cycles - elapsed);
+                continue;
+            }
+        }
+
+        if constexpr (code_bus<bus_t>) {
+            if (auto block = find_block(); block != nullptr) {
+                elapsed += run_block(*block, cycles - elapsed);
+                continue;
+            }
+        }
+
+        auto address = pc.value();
+        auto opcode = read(pc.advance());
+        if (auto fused = fused_set[opcode]; fused != nullptr) {
+            elapsed += fused(*this, cycles - elapsed);
+        }
+        else {
+            auto instruction_cycles = decode(opcode).complete(*this);
+            count(address, opcode, instruction_cycles);
+            elapsed += instruction_cycles;
         }
     }
 
-    current_instruction.execute(*this);
+    return elapsed;
+}
+
+template <bus bus_t>
+auto cpu<bus_t>::fetch() -> instruction {
+    if (interrupt_pending())
+        return interrupt_request();
+
+    auto opcode = read(pc.advance());
+    return decode(opcode);
+}
+
+// Executes one instruction, watching for a loop that does nothing but poll
+// the bus. Once such a loop comes round twice in the same state, with
+// nothing it polls changing in between, every round after is bound to be
+// the same too until something does: the rounds that fit in before then,
+// and in the cycles left to run, are skipped by advancing the bus clock
+template <bus bus_t>
+auto cpu<bus_t>::step_polling(int cycles) -> int {
+    auto address = pc.value();
+    auto opcode = read(pc.advance());
+    auto elapsed = decode(opcode).complete(*this);
+    count(address, opcode, elapsed);
+
+    auto info = OPCODES[opcode];
+    auto jumped_back = pc.value() <= address
+        and (info.addressing == addressing::rel or (info.mnemonic == mnemonic::jmp and info.addressing == addressing::abs));
+    if (jumped_back)
+        return elapsed + loop_back(address, cycles - elapsed);
+
+    if (pc.value() < idle_loop_.head or pc.value() > idle_loop_.tail)
+        idle_loop_.came_round = false;
+
+    return elapsed;
+}
+
+// The instruction at `tail` just branched back to PC
+template <bus bus_t>
+auto cpu<bus_t>::loop_back(std::uint16_t tail, int cycles) -> int {
+    auto head = pc.value();
+    if (head != idle_loop_.head or tail != idle_loop_.tail)
+        idle_loop_ = idle_loop{head, tail, is_polling_loop(head, tail)};
+
+    if (not idle_loop_.polls_only)
+        return 0;
+
+    auto registers = std::array{a.value(), x.value(), y.value(), s.value(), p.value()};
+    auto skipped = std::uint64_t{0};
+
+    // The last round started with the same registers, and with nothing it
+    // polls changing until `until`: so does every round up to then
+    if (idle_loop_.came_round and registers == idle_loop_.registers and cycles > 0) {
+        auto now = bus_.cycle();
+        auto round = now - idle_loop_.cycle;
+        auto until = idle_loop_.until;
+
+        auto rounds = std::min(until > now ? (until - now) / round : 0, static_cast<std::uint64_t>(cycles) / round);
+        skipped = rounds * round;
+        elapse(static_cast<int>(skipped));
+    }
+
+    idle_loop_.came_round = true;
+    idle_loop_.cycle = bus_.cycle();
+    idle_loop_.until = bus_.idle_until();
+    idle_loop_.registers = registers;
+
+    return static_cast<int>(skipped);
+}
+
+// Whether a round of the loop from `head` to `tail` reads nothing but
+// pollable addresses and writes nothing but registers, so that it depends
+// only on the registers it starts with and on what it polls
+template <bus bus_t>
+auto cpu<bus_t>::is_polling_loop(std::uint16_t head, std::uint16_t tail) -> bool {
+    if (tail - head >= IDLE_LOOP_BYTES)
+        return false;
+
+    auto address = int{head};
+    while (address < tail) {
+        auto opcode = peek(static_cast<std::uint16_t>(address));
+        if (not may_poll(opcode))
+            return false;
+
+        auto length = OPCODES[opcode].length;
+        if (OPCODES[opcode].access == memory_access::read) {
+            auto operand = int{peek(static_cast<std::uint16_t>(address + 1))};
+            if (length == 3)
+                operand |= peek(static_cast<std::uint16_t>(address + 2)) << 8;
+            if (not bus_.is_pollable(static_cast<std::uint16_t>(operand)))
+                return false;
+        }
+
+        address += length;
+    }
+
+    return address == tail;
+}
+
+// The block of predecoded code at PC, or nullptr if PC isn't in a code page
+// or nothing there could be predecoded
+template <bus bus_t>
+auto cpu<bus_t>::find_block() -> const code_block* {
+    auto address = pc.value();
+    auto page = bus_.code_page(static_cast<std::uint8_t>(address >> 8));
+    if (page == nullptr)
+        return nullptr;
+
+    if (block_at_.empty())
+        block_at_.resize(0x10000);
+
+    auto& block = block_at_[address];
+    if (block == nullptr or block->page != page) {
+        auto key = block_key{page, address};
+        auto entry = code_cache_.find(key);
+        if (entry == code_cache_.end())
+            entry = code_cache_.emplace(key, decode_block(page, address)).first;
+
+        block = &entry->second;
+    }
+
+    return block->code.empty() ? nullptr : block;
+}
+
+// Runs the block from its start, stopping early once `cycles` have gone by,
+// on an interrupt, or if the block's page gets mapped out from under it. The
+// interrupt line was already polled for the first instruction
+template <bus bus_t>
+auto cpu<bus_t>::run_block(const code_block& block, int cycles) -> int {
+    auto page = static_cast<std::uint8_t>(block.pc >> 8);
+    auto elapsed = execute(block.code.front());
+
+    for (auto code = block.code.begin() + 1; code != block.code.end(); ++code) {
+        if (elapsed >= cycles or bus_.code_page(page) != block.page)
+            break;
+
+        if (interrupt_pending())
+            return elapsed + interrupt_request().complete(*this);
+
+        elapsed += execute(*code);
+    }
+
+    return elapsed;
+}
+
+template <bus bus_t>
+auto cpu<bus_t>::decode_block(const std::uint8_t* page, std::uint16_t address) -> code_block {
+    auto block = code_block{page, address, {}};
+
+    for (auto offset = address & 0xFF; offset < 0x100;) {
+        auto opcode = page[offset];
+        auto handler = decode(opcode);
+
+        // An instruction running into the next page is left to the
+        // interpreter; that page may be mapped to anything
+        if (offset + handler.length() > 0x100)
+            break;
+
+        auto& code = block.code.emplace_back(predecoded_instruction{
+            static_cast<std::uint16_t>((address & 0xFF00) | offset),
+            {},
+            opcode,
+            handler});
+
+        for (auto i = 1; i < handler.length(); ++i)
+            code.operand[i - 1] = page[offset + i];
+
+        offset += handler.length();
+
+        if (ends_block(opcode))
+            break;
+    }
+
+    return block;
+}
+
+// Records the instruction at PC, and then runs it
+template <bus bus_t>
+auto cpu<bus_t>::run_traced() -> int {
+    auto address = pc.value();
+
+    auto record = trace_record{};
+    if constexpr (idle_bus<bus_t>)
+        record.cycle = bus_.cycle();
+    else
+        record.cycle = traced_cycles_;
+    record.pc = address;
+    record.bytes = {peek(address), peek(static_cast<std::uint16_t>(address + 1)), peek(static_cast<std::uint16_t>(address + 2))};
+    record.a = a.value();
+    record.x = x.value();
+    record.y = y.value();
+    record.p = p.value();
+    record.s = s.value();
+    tracer_->record(record);
+
+    auto opcode = read(pc.advance());
+    auto cycles = decode(opcode).complete(*this);
+    count(address, opcode, cycles);
+
+    traced_cycles_ += static_cast<std::uint64_t>(cycles);
+    return cycles;
 }
 
 template <bus bus_t>
-auto cpu<bus_t>::read_word(std::uint16_t addr) const -> std::uint16_t {
+auto cpu<bus_t>::execute(const predecoded_instruction& code) -> int {
+    pc.advance();
+    operands_ = code.operand.data();
+
+    // Operands come from the bus again however the instruction leaves
+    struct operands_end {
+        const std::uint8_t*& operands;
+        ~operands_end() { operands = nullptr; }
+    } end{operands_};
+
+    auto cycles = instruction{code.handler}.complete(*this);
+    count(code.pc, code.opcode, cycles);
+    return cycles;
+}
+
+template <bus bus_t>
+auto cpu<bus_t>::fetch_operand() -> std::uint8_t {
+    auto address = pc.advance();
+    if (operands_ != nullptr) {
+        next_cycle();
+        return *operands_++;
+    }
+
+    return read(address);
+}
+
+template <bus bus_t>
+auto cpu<bus_t>::fetch_operand_word() -> std::uint16_t {
+    auto lo = fetch_operand();
+    auto hi = fetch_operand();
+
+    return static_cast<std::uint16_t>((hi << 8) | lo);
+}
+
+template <bus bus_t>
+void cpu<bus_t>::flush_code_cache() {
+    code_cache_.clear();
+    block_at_.clear();
+}
+
+template <bus bus_t>
+auto cpu<bus_t>::read_word(std::uint16_t addr) -> std::uint16_t {
     auto lo = read(addr);
     auto hi = read(addr + 1);
 
@@ -149,37 +931,44 @@ auto cpu<bus_t>::read_word(std::uint16_t addr) const -> std::uint16_t {
 }
 
 template <bus bus_t>
-auto cpu<bus_t>::read_word_wrapped(std::uint16_t addr) const -> std::uint16_t {
+auto cpu<bus_t>::read_word_wrapped(std::uint16_t addr) -> std::uint16_t {
     auto lo = read(addr);
     auto hi = read((addr / 0x100) * 0x100 + (addr + 1) % 0x100);
     return (hi << 8) | lo;
 }
 
+// The pointer wraps round within the zero page
 template <bus bus_t>
-auto cpu<bus_t>::decode(std::uint8_t opcode) -> instruction {
-    auto found = instruction_set.find(opcode);
-    if (found == std::end(instruction_set))
-        return instruction{
-            [opcode](auto...) -> int { throw unsupported_opcode(opcode); },
-            imp};
+auto cpu<bus_t>::read_zero_page_word(std::uint8_t addr) -> std::uint16_t {
+    auto lo = read_zero_page(addr);
+    auto hi = read_zero_page(static_cast<std::uint8_t>(addr + 1));
+    return (hi << 8) | lo;
+}
 
-    return found->second;
+template <bus bus_t>
+auto cpu<bus_t>::decode(std::uint8_t opcode) -> instruction {
+    return instruction_set[opcode];
 }
 
 template <bus bus_t>
 auto cpu<bus_t>::interrupt() -> int {
-    write(s.push(), pc.hi());
-    write(s.push(), pc.lo());
-    pc.assign(read_word(0xFFFA));
-
-    write(s.push(), p.value());
+    // Like BRK, less the opcode fetch, which still takes its cycle, and with
+    // the B flag pushed clear. With no IRQ line, it can only be an NMI
+    idle_cycle();
+    push(pc.hi());
+    push(pc.lo());
+    push(static_cast<std::uint8_t>(p.value() & ~0x10));
+
+    pc.assign(read_word(interrupt_vector(interrupt_bus<bus_t> ? IRQ_VECTOR : NMI_VECTOR)));
     p.set(cpu_flag::int_disable);
 
     return 7;
 }
 
+// Between instructions, the state is the same whichever way the last ran
 template <bus bus_t>
 auto cpu<bus_t>::save_state() const -> state {
+    auto in_progress = current_instruction.is_finished() ? instruction{} : current_instruction;
     return state{
         pc.value(),
         s.value(),
@@ -187,7 +976,10 @@ auto cpu<bus_t>::save_state() const -> state {
         a.value(),
         x.value(),
         y.value(),
-        current_instruction};
+        static_cast<std::uint8_t>(in_progress.opcode()),
+        in_progress.opcode() == instruction::INTERRUPT,
+        static_cast<std::uint8_t>(in_progress.cycles_left()),
+        static_cast<std::uint8_t>(in_progress.additional_cycles_left())};
 }
 
 template <bus bus_t>
@@ -198,281 +990,65 @@ void cpu<bus_t>::load_state(state state) {
     a.assign(state.a);
     x.assign(state.x);
     y.assign(state.y);
-    current_instruction = state.cix;
+
+    current_instruction = state.interrupt ? interrupt_request() : decode(state.opcode);
+    current_instruction.resume(state.cycles_left, state.additional_cycles_left);
 }
 
 template <bus bus_t>
-const std::unordered_map<std::uint8_t, typename cpu<bus_t>::instruction, typename cpu<bus_t>::hasher> cpu<bus_t>::instruction_set{
-    {0xEA, {nop, imp, 2}},
-
-    {0x1A, {nop, imp, 2}},
-    {0x3A, {nop, imp, 2}},
-    {0x5A, {nop, imp, 2}},
-    {0x7A, {nop, imp, 2}},
-    {0xDA, {nop, imp, 2}},
-    {0xFA, {nop, imp, 2}},
-    {0x82, {nop, imp, 2}},
-
-    {0x04, {i_n, zp, 3} },
-    {0x44, {i_n, zp, 3} },
-    {0x64, {i_n, zp, 3} },
-    {0x0C, {i_n, abs, 4}},
-
-    {0x14, {i_n, zpx, 4}},
-    {0x34, {i_n, zpx, 4}},
-    {0x54, {i_n, zpx, 4}},
-    {0x74, {i_n, zpx, 4}},
-    {0xD4, {i_n, zpx, 4}},
-    {0xF4, {i_n, zpx, 4}},
-
-    {0x1C, {i_n, abx, 4}},
-    {0x3C, {i_n, abx, 4}},
-    {0x5C, {i_n, abx, 4}},
-    {0x7C, {i_n, abx, 4}},
-    {0xDC, {i_n, abx, 4}},
-    {0xFC, {i_n, abx, 4}},
-
-    {0x80, {i_n, imm, 2}},
-    {0x89, {i_n, imm, 2}},
-
-    {0xA7, {lax, zp, 3} },
-    {0xB7, {lax, zpy, 4}},
-    {0xAF, {lax, abs, 4}},
-    {0xBF, {lax, aby, 4}},
-    {0xA3, {lax, izx, 6}},
-    {0xB3, {lax, izy, 5}},
-
-    {0x87, {sax, zp, 3} },
-    {0x97, {sax, zpy, 4}},
-    {0x8F, {sax, abs, 4}},
-    {0x83, {sax, izx, 6}},
-
-    {0xC7, {dcp, zp, 5} },
-    {0xD7, {dcp, zpx, 6}},
-    {0xCF, {dcp, abs, 6}},
-    {0xDF, {dcp, abx, 7}},
-    {0xDB, {dcp, aby, 7}},
-    {0xC3, {dcp, izx, 8}},
-    {0xD3, {dcp, izy, 8}},
-
-    {0xE7, {isc, zp, 5} },
-    {0xF7, {isc, zpx, 6}},
-    {0xEF, {isc, abs, 6}},
-    {0xFF, {isc, abx, 7}},
-    {0xFB, {isc, aby, 7}},
-    {0xE3, {isc, izx, 8}},
-    {0xF3, {isc, izy, 8}},
-
-    {0x07, {slo, zp, 5} },
-    {0x17, {slo, zpx, 6}},
-    {0x0F, {slo, abs, 6}},
-    {0x1F, {slo, abx, 7}},
-    {0x1B, {slo, aby, 7}},
-    {0x03, {slo, izx, 8}},
-    {0x13, {slo, izy, 8}},
-
-    {0x47, {sre, zp, 5} },
-    {0x57, {sre, zpx, 6}},
-    {0x4F, {sre, abs, 6}},
-    {0x5F, {sre, abx, 7}},
-    {0x5B, {sre, aby, 7}},
-    {0x43, {sre, izx, 8}},
-    {0x53, {sre, izy, 8}},
-
-    {0x27, {rla, zp, 5} },
-    {0x37, {rla, zpx, 6}},
-    {0x2F, {rla, abs, 6}},
-    {0x3F, {rla, abx, 7}},
-    {0x3B, {rla, aby, 7}},
-    {0x23, {rla, izx, 8}},
-    {0x33, {rla, izy, 8}},
-
-    {0x67, {rra, zp, 5} },
-    {0x77, {rra, zpx, 6}},
-    {0x6F, {rra, abs, 6}},
-    {0x7F, {rra, abx, 7}},
-    {0x7B, {rra, aby, 7}},
-    {0x63, {rra, izx, 8}},
-    {0x73, {rra, izy, 8}},
-
-    {0xA9, {lda, imm, 2}},
-    {0xA5, {lda, zp, 3} },
-    {0xB5, {lda, zpx, 4}},
-    {0xAD, {lda, abs, 4}},
-    {0xBD, {lda, abx, 4}},
-    {0xB9, {lda, aby, 4}},
-    {0xA1, {lda, izx, 6}},
-    {0xB1, {lda, izy, 5}},
-
-    {0x85, {sta, zp, 3} },
-    {0x95, {sta, zpx, 4}},
-    {0x8D, {sta, abs, 4}},
-    {0x9D, {sta, abx, 5}},
-    {0x99, {sta, aby, 5}},
-    {0x81, {sta, izx, 6}},
-    {0x91, {sta, izy, 6}},
-
-    {0xA2, {ldx, imm, 2}},
-    {0xA6, {ldx, zp, 3} },
-    {0xB6, {ldx, zpy, 4}},
-    {0xAE, {ldx, abs, 4}},
-    {0xBE, {ldx, aby, 4}},
-
-    {0x86, {stx, zp, 3} },
-    {0x96, {stx, zpy, 4}},
-    {0x8E, {stx, abs, 4}},
-
-    {0xA0, {ldy, imm, 2}},
-    {0xA4, {ldy, zp, 3} },
-    {0xB4, {ldy, zpx, 4}},
-    {0xAC, {ldy, abs, 4}},
-    {0xBC, {ldy, abx, 4}},
-
-    {0x84, {sty, zp, 3} },
-    {0x94, {sty, zpx, 4}},
-    {0x8C, {sty, abs, 4}},
-
-    {0xAA, {tax, imp, 2}},
-    {0x8A, {txa, imp, 2}},
-    {0xA8, {tay, imp, 2}},
-    {0x98, {tya, imp, 2}},
-
-    {0xBA, {tsx, imp, 2}},
-    {0x9A, {txs, imp, 2}},
-    {0x48, {pha, imp, 3}},
-    {0x68, {pla, imp, 4}},
-    {0x08, {php, imp, 3}},
-    {0x28, {plp, imp, 4}},
-
-    {0x69, {adc, imm, 2}},
-    {0x65, {adc, zp, 3} },
-    {0x75, {adc, zpx, 4}},
-    {0x6D, {adc, abs, 4}},
-    {0x7D, {adc, abx, 4}},
-    {0x79, {adc, aby, 4}},
-    {0x61, {adc, izx, 6}},
-    {0x71, {adc, izy, 5}},
-
-    {0xE9, {sbc, imm, 2}},
-    {0xEB, {sbc, imm, 2}},
-    {0xE5, {sbc, zp, 3} },
-    {0xF5, {sbc, zpx, 4}},
-    {0xED, {sbc, abs, 4}},
-    {0xFD, {sbc, abx, 4}},
-    {0xF9, {sbc, aby, 4}},
-    {0xE1, {sbc, izx, 6}},
-    {0xF1, {sbc, izy, 5}},
-
-    {0xC9, {cmp, imm, 2}},
-    {0xC5, {cmp, zp, 3} },
-    {0xD5, {cmp, zpx, 4}},
-    {0xCD, {cmp, abs, 4}},
-    {0xDD, {cmp, abx, 4}},
-    {0xD9, {cmp, aby, 4}},
-    {0xC1, {cmp, izx, 6}},
-    {0xD1, {cmp, izy, 5}},
-
-    {0xE0, {cpx, imm, 2}},
-    {0xE4, {cpx, zp, 3} },
-    {0xEC, {cpx, abs, 4}},
-
-    {0xC0, {cpy, imm, 2}},
-    {0xC4, {cpy, zp, 3} },
-    {0xCC, {cpy, abs, 4}},
-
-    {0xE6, {inc, zp, 5} },
-    {0xF6, {inc, zpx, 6}},
-    {0xEE, {inc, abs, 6}},
-    {0xFE, {inc, abx, 7}},
-
-    {0xC6, {dec, zp, 5} },
-    {0xD6, {dec, zpx, 6}},
-    {0xCE, {dec, abs, 6}},
-    {0xDE, {dec, abx, 7}},
-
-    {0xE8, {inx, imp, 2}},
-    {0xC8, {iny, imp, 2}},
-
-    {0xCA, {dex, imp, 2}},
-    {0x88, {dey, imp, 2}},
-
-    {0x0A, {asl, acc, 2}},
-    {0x06, {asl, zp, 5} },
-    {0x16, {asl, zpx, 6}},
-    {0x0E, {asl, abs, 6}},
-    {0x1E, {asl, abx, 7}},
-
-    {0x4A, {lsr, acc, 2}},
-    {0x46, {lsr, zp, 5} },
-    {0x56, {lsr, zpx, 6}},
-    {0x4E, {lsr, abs, 6}},
-    {0x5E, {lsr, abx, 7}},
-
-    {0x2A, {rol, acc, 2}},
-    {0x26, {rol, zp, 5} },
-    {0x36, {rol, zpx, 6}},
-    {0x2E, {rol, abs, 6}},
-    {0x3E, {rol, abx, 7}},
-
-    {0x6A, {ror, acc, 2}},
-    {0x66, {ror, zp, 5} },
-    {0x76, {ror, zpx, 6}},
-    {0x6E, {ror, abs, 6}},
-    {0x7E, {ror, abx, 7}},
-
-    {0x29, {ana, imm, 2}},
-    {0x25, {ana, zp, 3} },
-    {0x35, {ana, zpx, 4}},
-    {0x2D, {ana, abs, 4}},
-    {0x3D, {ana, abx, 4}},
-    {0x39, {ana, aby, 4}},
-    {0x21, {ana, izx, 6}},
-    {0x31, {ana, izy, 5}},
-
-    {0x09, {ora, imm, 2}},
-    {0x05, {ora, zp, 3} },
-    {0x15, {ora, zpx, 4}},
-    {0x0D, {ora, abs, 4}},
-    {0x1D, {ora, abx, 4}},
-    {0x19, {ora, aby, 4}},
-    {0x01, {ora, izx, 6}},
-    {0x11, {ora, izy, 5}},
-
-    {0x49, {eor, imm, 2}},
-    {0x45, {eor, zp, 3} },
-    {0x55, {eor, zpx, 4}},
-    {0x4D, {eor, abs, 4}},
-    {0x5D, {eor, abx, 4}},
-    {0x59, {eor, aby, 4}},
-    {0x41, {eor, izx, 6}},
-    {0x51, {eor, izy, 5}},
-
-    {0x24, {bit, zp, 3} },
-    {0x2C, {bit, abs, 4}},
-
-    {0x10, {bpl, rel, 2}},
-    {0x30, {bmi, rel, 2}},
-    {0x50, {bvc, rel, 2}},
-    {0x70, {bvs, rel, 2}},
-    {0x90, {bcc, rel, 2}},
-    {0xB0, {bcs, rel, 2}},
-    {0xD0, {bne, rel, 2}},
-    {0xF0, {beq, rel, 2}},
-
-    {0x18, {clc, imp, 2}},
-    {0x38, {sec, imp, 2}},
-    {0xD8, {cld, imp, 2}},
-    {0xF8, {sed, imp, 2}},
-    {0x58, {cli, imp, 2}},
-    {0x78, {sei, imp, 2}},
-    {0xB8, {clv, imp, 2}},
-
-    {0x4C, {jmp, abs, 3}},
-    {0x6C, {jmp, ind, 5}},
-    {0x20, {jsr, abs, 6}},
-    {0x60, {rts, imp, 6}},
-    {0x40, {rti, imp, 6}},
-    {0x00, {brk, imp, 7}}
-};
+constexpr auto cpu<bus_t>::make_instruction_set() -> std::array<instruction, 256> {
+    // Unsupported opcodes have no cycles of their own; they trap on the first
+    return []<std::size_t... opcode>(std::index_sequence<opcode...>) {
+        return std::array<instruction, 256>{
+            instruction{&execute_opcode<opcode>, std::max(OPCODES[opcode].cycles, 1), OPCODES[opcode].length, opcode}...};
+    }(std::make_index_sequence<256>{});
+}
+
+template <bus bus_t>
+constinit const std::array<typename cpu<bus_t>::instruction, 256> cpu<bus_t>::instruction_set = make_instruction_set();
+
+template <bus bus_t>
+template <std::uint8_t opcode>
+auto cpu<bus_t>::execute_fused(cpu& cpu, int cycles) -> int {
+    auto address = static_cast<std::uint16_t>(cpu.pc.value() - 1);
+    auto elapsed = cpu.template complete_opcode<opcode>();
+    cpu.count(address, opcode, elapsed);
+
+    constexpr auto tails = tails_of(opcode);
+    if constexpr (tails.count > 0) {
+        if (elapsed >= cycles)
+            return elapsed;
+
+        if (cpu.interrupt_pending()) {
+            cpu.idle_loop_.came_round = false;
+            return elapsed + interrupt_request().complete(cpu);
+        }
+
+        auto next_address = cpu.pc.value();
+        auto next = cpu.read(cpu.pc.advance());
+        auto next_cycles = 0;
+        auto fused = [&]<std::size_t... i>(std::index_sequence<i...>) {
+            return ((next == tails.opcodes[i] and (next_cycles = cpu.template complete_opcode<tails.opcodes[i]>(), true)) or ...);
+        }(std::make_index_sequence<tails.count>{});
+
+        if (not fused)
+            next_cycles = cpu.decode(next).complete(cpu);
+
+        cpu.count(next_address, next, next_cycles);
+        elapsed += next_cycles;
+    }
+
+    return elapsed;
+}
+
+template <bus bus_t>
+constexpr auto cpu<bus_t>::make_fused_set() -> std::array<fused_handler, 256> {
+    return []<std::size_t... opcode>(std::index_sequence<opcode...>) {
+        return std::array<fused_handler, 256>{(tails_of(opcode).count > 0 ? &execute_fused<opcode> : nullptr)...};
+    }(std::make_index_sequence<256>{});
+}
+
+template <bus bus_t>
+constinit const std::array<typename cpu<bus_t>::fused_handler, 256> cpu<bus_t>::fused_set = make_fused_set();
 
 }// namespace nes
\ No newline at end of file
@@ -1,9 +1,10 @@
 #pragma once
 
-#include <optional>
 #include <tuple>
 #include <cstdint>
+#include <type_traits>
 
+#include <libnes/cpu_opcodes.hpp>
 #include <libnes/cpu_operations.hpp>
 
 namespace nes
@@ -12,7 +13,14 @@ namespace nes
 struct implied_address_mode {
 };
 
-const auto imp = [](auto&) {
+// Address modes take the CPU and what the instruction does with its
+// operand, as a memory_access constant: reads, writes and read-modify-writes
+// of the same operand spend their cycles differently
+
+template <memory_access access>
+using access_constant = std::integral_constant<memory_access, access>;
+
+const auto imp = [](auto&, auto) {
     return implied_address_mode{};
 };
 
@@ -37,126 +45,143 @@ private:
     cpu_t& cpu_;
 };
 
-const auto acc = [](auto& cpu) {
+const auto acc = [](auto& cpu, auto) {
     return accumulator_address_mode{cpu};
 };
 
 
-template <class fettch_addr_t, class cpu_t>
-struct memory_based_address_mode {
-    memory_based_address_mode(cpu_t& c, fettch_addr_t fetch_addr)
-        : cpu_(c)
-        , fetch_addr_(fetch_addr) {}
+// The operand of an instruction that addresses memory. The address mode
+// works out the effective address once, before the operation runs, and
+// the operation only ever reads or writes through it. One in the zero page
+// can only be in RAM
+template <class cpu_t, class access_t, bool zero_page = false>
+struct memory_operand {
+    cpu_t& cpu;
+    access_t access;
+    std::uint16_t address;
+    int additional_cycles{0};
+    std::uint8_t loaded{0};
 
     [[nodiscard]] auto load_operand() {
-        fetch_address();
-        auto [address, additional_cycles] = result_.value();
-        return std::tuple{cpu_.read(address), additional_cycles};
+        loaded = read(address);
+        return std::tuple{loaded, additional_cycles};
     }
 
     auto store_operand(std::uint8_t operand) {
-        fetch_address();
-        auto [address, additional_cycles] = result_.value();
-        cpu_.write(address, operand);
+        if constexpr (access_t::value == memory_access::read_modify_write and zero_page)
+            cpu.dummy_write_zero_page(static_cast<std::uint8_t>(address), loaded);
+        else if constexpr (access_t::value == memory_access::read_modify_write)
+            cpu.dummy_write(address, loaded);
+
+        write(address, operand);
         return additional_cycles;
     }
 
-    auto fetch_address() {
-        if (!result_) {
-            result_ = fetch_addr_(cpu_);
-        }
-        return result_.value();
+    [[nodiscard]] auto fetch_address() const {
+        return std::tuple{address, additional_cycles};
     }
 
 private:
-    cpu_t& cpu_;
-    std::optional<std::tuple<std::uint16_t, int>> result_;
-    fettch_addr_t fetch_addr_;
+    [[nodiscard]] auto read(std::uint16_t addr) {
+        if constexpr (zero_page)
+            return cpu.read_zero_page(static_cast<std::uint8_t>(addr));
+        else
+            return cpu.read(addr);
+    }
+
+    void write(std::uint16_t addr, std::uint8_t value) {
+        if constexpr (zero_page)
+            cpu.write_zero_page(static_cast<std::uint8_t>(addr), value);
+        else
+            cpu.write(addr, value);
+    }
+};
+
+// The CPU adds the index to the low byte first, and reads from there before
+// carrying into the high byte -- unless it's only reading and there's no
+// carry, in which case that read is the one it wanted
+template <class cpu_t, class access_t>
+auto indexed_operand(cpu_t& cpu, access_t access, std::uint16_t base, std::int16_t offset) {
+    const auto address = static_cast<std::uint16_t>(base + offset);
+    const auto page_crossed = is_page_crossed(base, address);
+
+    if (access != memory_access::read or page_crossed)
+        cpu.dummy_read(static_cast<std::uint16_t>((base & 0xFF00) | (address & 0x00FF)));
+
+    return memory_operand{cpu, access, address, page_crossed ? 1 : 0};
+}
+
+template <class cpu_t, class access_t>
+auto zero_page_operand(cpu_t& cpu, access_t access, int address) {
+    return memory_operand<cpu_t, access_t, true>{cpu, access, static_cast<std::uint16_t>(address % 0x100)};
+}
+
+// The byte after the opcode, fetched like any other operand byte, and so
+// out of the predecoded block when there is one
+struct immediate_operand {
+    std::uint8_t value;
+
+    [[nodiscard]] auto load_operand() const {
+        return std::tuple{value, 0};
+    }
 };
 
-const auto imm = [](auto& cpu) {
-    auto fetch_addr = [](auto& cpu) {
-        return std::tuple{cpu.pc.advance(), 0};
-    };
-    return memory_based_address_mode{cpu, fetch_addr};
+const auto imm = [](auto& cpu, auto) {
+    return immediate_operand{cpu.fetch_operand()};
 };
 
-const auto zp = [](auto& cpu) {
-    auto fetch_addr = [](auto& cpu) {
-        return std::tuple{cpu.read(cpu.pc.advance()), 0};
-    };
-    return memory_based_address_mode{cpu, fetch_addr};
+const auto zp = [](auto& cpu, auto access) {
+    return zero_page_operand(cpu, access, cpu.fetch_operand());
 };
 
-const auto zpx = [](auto& cpu) {
-    auto fetch_addr = [](auto& cpu) {
-        auto address = cpu.read(cpu.pc.advance());
-        return std::tuple{(cpu.x.value() + address) % 0x100, 0};
-    };
-    return memory_based_address_mode{cpu, fetch_addr};
+// Indexed zero page reads the unindexed address while it adds
+const auto zpx = [](auto& cpu, auto access) {
+    auto base = cpu.fetch_operand();
+    cpu.idle_cycle();
+    return zero_page_operand(cpu, access, base + cpu.x.value());
 };
 
-const auto zpy = [](auto& cpu) {
-    auto fetch_addr = [](auto& cpu) {
-        auto address = cpu.read(cpu.pc.advance());
-        return std::tuple{(cpu.y.value() + address) % 0x100, 0};
-    };
-    return memory_based_address_mode{cpu, fetch_addr};
+const auto zpy = [](auto& cpu, auto access) {
+    auto base = cpu.fetch_operand();
+    cpu.idle_cycle();
+    return zero_page_operand(cpu, access, base + cpu.y.value());
 };
 
-const auto abs = [](auto& cpu) {
-    auto fetch_addr = [](auto& cpu) {
-        auto address = cpu.read_word(cpu.pc.advance(2));
-        return std::tuple{address, 0};
-    };
-    return memory_based_address_mode{cpu, fetch_addr};
+const auto abs = [](auto& cpu, auto access) {
+    return memory_operand{cpu, access, cpu.fetch_operand_word()};
 };
 
-const auto abx = [](auto& cpu) {
-    auto fetch_addr = [](auto& cpu) {
-        return index(cpu.read_word(cpu.pc.advance(2)), cpu.x.value());
-    };
-    return memory_based_address_mode{cpu, fetch_addr};
+const auto abx = [](auto& cpu, auto access) {
+    return indexed_operand(cpu, access, cpu.fetch_operand_word(), cpu.x.value());
 };
 
-const auto aby = [](auto& cpu) {
-    auto fetch_addr = [](auto& cpu) {
-        return index(cpu.read_word(cpu.pc.advance(2)), cpu.y.value());
-    };
-    return memory_based_address_mode{cpu, fetch_addr};
+const auto aby = [](auto& cpu, auto access) {
+    return indexed_operand(cpu, access, cpu.fetch_operand_word(), cpu.y.value());
 };
 
-const auto ind = [](auto& cpu) {
-    auto fetch_addr = [](auto& cpu) {
-        auto address = cpu.read_word(cpu.pc.advance(2));
-        return std::tuple{cpu.read_word_wrapped(address), 0};
-    };
-    return memory_based_address_mode{cpu, fetch_addr};
+const auto ind = [](auto& cpu, auto access) {
+    return memory_operand{cpu, access, cpu.read_word_wrapped(cpu.fetch_operand_word())};
 };
 
-const auto izx = [](auto& cpu) {
-    auto fetch_addr = [](auto& cpu) {
-        auto indexed = static_cast<std::uint16_t>((cpu.read(cpu.pc.advance()) + cpu.x.value()) % 0x100);
-        return std::tuple{cpu.read_word_wrapped(indexed), 0};
-    };
-    return memory_based_address_mode{cpu, fetch_addr};
+const auto izx = [](auto& cpu, auto access) {
+    auto base = cpu.fetch_operand();
+    cpu.idle_cycle();
+    auto indexed = static_cast<std::uint8_t>(base + cpu.x.value());
+    return memory_operand{cpu, access, cpu.read_zero_page_word(indexed)};
 };
 
-const auto izy = [](auto& cpu) {
-    auto fetch_addr = [](auto& cpu) {
-        auto base = cpu.read(cpu.pc.advance());
-        auto ad = cpu.read_word_wrapped(base);
-        return index(ad, cpu.y.value());
-    };
-    return memory_based_address_mode{cpu, fetch_addr};
+const auto izy = [](auto& cpu, auto access) {
+    auto base = cpu.read_zero_page_word(cpu.fetch_operand());
+    return indexed_operand(cpu, access, base, cpu.y.value());
 };
 
-const auto rel = [](auto& cpu) {
-    auto fetch_addr = [](auto& cpu) {
-        auto offset = cpu.read_signed(cpu.pc.advance());
-        return index(cpu.pc.value(), offset);
-    };
-    return memory_based_address_mode{cpu, fetch_addr};
+// What a taken branch spends on top of the two cycles is left to the end
+// of the instruction: it only reads the code it's about to run
+const auto rel = [](auto& cpu, auto access) {
+    auto offset = static_cast<std::int8_t>(cpu.fetch_operand());
+    auto base = cpu.pc.value();
+    auto target = static_cast<std::uint16_t>(base + offset);
+    return memory_operand{cpu, access, target, is_page_crossed(base, target) ? 1 : 0};
 };
 
-}// namespace nes
\ No newline at end of file
+}// namespace nes
@@ -0,0 +1,53 @@
+#include <libnes/cpu_disassembler.hpp>
+
+namespace nes
+{
+
+auto disassemble(std::uint16_t pc, std::span<const std::uint8_t> bytes) -> std::string {
+    auto info = OPCODES[bytes[0]];
+    auto mnemonic = std::format("{}{}", info.official ? "" : "*", name(info.mnemonic));
+
+    auto lo = info.length > 1 ? bytes[1] : 0;
+    auto word = info.length > 2 ? lo | (bytes[2] << 8) : lo;
+
+    switch (info.addressing) {
+        case addressing::imp:
+            return mnemonic;
+        case addressing::acc:
+            return mnemonic + " A";
+        case addressing::imm:
+            return std::format("{} #${:02X}", mnemonic, lo);
+        case addressing::zp:
+            return std::format("{} ${:02X}", mnemonic, lo);
+        case addressing::zpx:
+            return std::format("{} ${:02X},X", mnemonic, lo);
+        case addressing::zpy:
+            return std::format("{} ${:02X},Y", mnemonic, lo);
+        case addressing::abs:
+            return std::format("{} ${:04X}", mnemonic, word);
+        case addressing::abx:
+            return std::format("{} ${:04X},X", mnemonic, word);
+        case addressing::aby:
+            return std::format("{} ${:04X},Y", mnemonic, word);
+        case addressing::ind:
+            return std::format("{} (${:04X})", mnemonic, word);
+        case addressing::izx:
+            return std::format("{} (${:02X},X)", mnemonic, lo);
+        case addressing::izy:
+            return std::format("{} (${:02X}),Y", mnemonic, lo);
+        case addressing::rel:
+            return std::format("{} ${:04X}", mnemonic, static_cast<std::uint16_t>(pc + 2 + static_cast<std::int8_t>(lo)));
+    }
+
+    return mnemonic;
+}
+
+auto hex_dump(std::span<const std::uint8_t> bytes) -> std::string {
+    auto dump = std::string{};
+    for (auto byte: bytes)
+        dump += std::format("{}{:02X}", dump.empty() ? "" : " ", byte);
+
+    return dump;
+}
+
+}// namespace nes
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <libnes/cpu_opcodes.hpp>
+
+#include <cstdint>
+#include <format>
+#include <span>
+#include <string>
+
+namespace nes
+{
+
+// One instruction in assembler syntax, as nestest.log has it: "LDA ($80),Y",
+// "ASL A", "*NOP $04". `bytes` starts with the opcode and holds at least the
+// instruction's length; branches need `pc` to show their target
+[[nodiscard]] auto disassemble(std::uint16_t pc, std::span<const std::uint8_t> bytes) -> std::string;
+
+// The instruction's bytes in hex, e.g. "4C F5 C5"
+[[nodiscard]] auto hex_dump(std::span<const std::uint8_t> bytes) -> std::string;
+
+// A line of a nestest-style trace: the instruction about to run at the
+// state's PC, the registers it runs with and, when the state has one, the
+// cycle it starts on
+[[nodiscard]] auto trace_line(const auto& state, std::span<const std::uint8_t> bytes) -> std::string {
+    auto instruction = bytes.first(static_cast<std::size_t>(OPCODES[bytes[0]].length));
+
+    // Unofficial opcodes have their star in the column before the mnemonic
+    auto text = disassemble(state.pc, instruction);
+    if (OPCODES[bytes[0]].official)
+        text.insert(0, " ");
+
+    auto line = std::format(
+        "{:04X}  {:<8} {:<33}A:{:02X} X:{:02X} Y:{:02X} P:{:02X} SP:{:02X}",
+        state.pc,
+        hex_dump(instruction),
+        text,
+        state.a,
+        state.x,
+        state.y,
+        state.p,
+        state.s
+    );
+
+    if constexpr (requires { state.cycle; })
+        line += std::format(" CYC:{}", state.cycle);
+
+    return line;
+}
+
+}// namespace nes
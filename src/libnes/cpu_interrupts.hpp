@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+namespace nes
+{
+
+// What may hold the IRQ line: the APU's frame counter and DMC, and the
+// cartridge
+enum class irq_source : std::uint8_t {
+    frame_counter = 0x01,
+    dmc = 0x02,
+    mapper = 0x04,
+};
+
+// The CPU's two interrupt inputs, kept as one mask of what is pending so
+// that the CPU has a single thing to check before each instruction.
+// NMI is edge-triggered: a rising edge latches a request, which the CPU
+// takes once. IRQ is a level, which any number of sources may hold at a
+// time: the CPU takes it whenever the I flag lets it, for as long as one
+// of them does
+class interrupt_lines
+{
+public:
+    constexpr void raise_nmi() noexcept { pending_ |= NMI; }
+
+    constexpr void set_irq(irq_source source, bool asserted) noexcept {
+        if (asserted)
+            pending_ |= static_cast<std::uint8_t>(source);
+        else
+            pending_ &= static_cast<std::uint8_t>(~static_cast<std::uint8_t>(source));
+    }
+
+    [[nodiscard]] constexpr auto pending(bool irq_disabled) const noexcept -> bool {
+        return (pending_ & (irq_disabled ? NMI : ALL)) != 0;
+    }
+
+    [[nodiscard]] constexpr auto nmi() const noexcept -> bool { return (pending_ & NMI) != 0; }
+    [[nodiscard]] constexpr auto irq() const noexcept -> bool { return (pending_ & ~NMI) != 0; }
+
+    // Taking the NMI clears the latch; false if there was none to take
+    constexpr auto acknowledge_nmi() noexcept -> bool {
+        auto latched = nmi();
+        pending_ &= static_cast<std::uint8_t>(~NMI);
+        return latched;
+    }
+
+private:
+    static constexpr std::uint8_t NMI = 0x80;
+    static constexpr std::uint8_t ALL = 0xFF;
+
+    std::uint8_t pending_{0};
+};
+
+}// namespace nes
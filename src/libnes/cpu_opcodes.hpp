@@ -0,0 +1,556 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <string_view>
+
+namespace nes
+{
+
+// Everything there is to know about the 256 opcodes, in one table built at
+// compile time: the CPU's decoder is generated from it, and so are the
+// disassembler and the tracer
+
+enum class mnemonic : std::uint8_t {
+    unsupported,
+    adc, ana, asl, bcc, bcs, beq, bit, bmi, bne, bpl, brk, bvc, bvs, clc,
+    cld, cli, clv, cmp, cpx, cpy, dcp, dec, dex, dey, eor, i_n, inc, inx,
+    iny, isc, jmp, jsr, lax, lda, ldx, ldy, lsr, nop, ora, pha, php, pla,
+    plp, rla, rol, ror, rra, rti, rts, sax, sbc, sec, sed, sei, slo, sre,
+    sta, stx, sty, tax, tay, tsx, txa, txs, tya
+};
+
+enum class addressing : std::uint8_t {
+    imp, acc, imm, zp, zpx, zpy, abs, abx, aby, ind, izx, izy, rel
+};
+
+// What an instruction does with the memory its operand addresses
+enum class memory_access : std::uint8_t {
+    none,
+    read,
+    write,
+    read_modify_write
+};
+
+struct opcode_info {
+    nes::mnemonic mnemonic{nes::mnemonic::unsupported};
+    nes::addressing addressing{nes::addressing::imp};
+
+    int length{1};// bytes, opcode included
+    int cycles{0};// base cycles
+
+    // One more cycle when indexing crosses a page; branches also take one
+    // when taken
+    bool page_penalty{false};
+
+    memory_access access{memory_access::none};
+    bool official{false};
+};
+
+[[nodiscard]] constexpr auto name(mnemonic m) noexcept -> std::string_view {
+    constexpr std::string_view names[] = {
+        "???",
+        "ADC", "AND", "ASL", "BCC", "BCS", "BEQ", "BIT", "BMI", "BNE", "BPL", "BRK", "BVC", "BVS", "CLC",
+        "CLD", "CLI", "CLV", "CMP", "CPX", "CPY", "DCP", "DEC", "DEX", "DEY", "EOR", "NOP", "INC", "INX",
+        "INY", "ISB", "JMP", "JSR", "LAX", "LDA", "LDX", "LDY", "LSR", "NOP", "ORA", "PHA", "PHP", "PLA",
+        "PLP", "RLA", "ROL", "ROR", "RRA", "RTI", "RTS", "SAX", "SBC", "SEC", "SED", "SEI", "SLO", "SRE",
+        "STA", "STX", "STY", "TAX", "TAY", "TSX", "TXA", "TXS", "TYA"};
+    static_assert(std::size(names) == static_cast<std::size_t>(mnemonic::tya) + 1);
+
+    return names[static_cast<std::size_t>(m)];
+}
+
+[[nodiscard]] constexpr auto operand_length(addressing mode) noexcept -> int {
+    switch (mode) {
+        case addressing::imp:
+        case addressing::acc:
+            return 0;
+        case addressing::abs:
+        case addressing::abx:
+        case addressing::aby:
+        case addressing::ind:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+// Branches, jumps, calls, returns and BRK: the instructions that may take
+// the program counter anywhere else than the next instruction
+[[nodiscard]] constexpr auto changes_flow(mnemonic m) noexcept -> bool {
+    using enum mnemonic;
+    switch (m) {
+        case bcc: case bcs: case beq: case bmi: case bne: case bpl: case bvc: case bvs:
+        case jmp: case jsr: case rts: case rti: case brk:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Whether the instruction touches the stack
+[[nodiscard]] constexpr auto uses_stack(mnemonic m) noexcept -> bool {
+    using enum mnemonic;
+    switch (m) {
+        case pha: case php: case pla: case plp: case jsr: case rts: case rti: case brk:
+            return true;
+        default:
+            return false;
+    }
+}
+
+inline namespace details
+{
+
+[[nodiscard]] constexpr auto memory_access_of(mnemonic m, addressing mode) noexcept -> memory_access {
+    using enum mnemonic;
+    if (mode == addressing::imp or mode == addressing::acc or mode == addressing::rel or m == jmp or m == jsr)
+        return memory_access::none;
+
+    switch (m) {
+        case sta: case stx: case sty: case sax:
+            return memory_access::write;
+        case inc: case dec: case asl: case lsr: case rol: case ror:
+        case dcp: case isc: case slo: case sre: case rla: case rra:
+            return memory_access::read_modify_write;
+        default:
+            return mode == addressing::imm ? memory_access::none : memory_access::read;
+    }
+}
+
+[[nodiscard]] constexpr auto has_page_penalty(mnemonic m, addressing mode) noexcept -> bool {
+    if (mode == addressing::rel)
+        return true;
+
+    auto indexed = mode == addressing::abx or mode == addressing::aby or mode == addressing::izy;
+    return indexed and memory_access_of(m, mode) == memory_access::read;
+}
+
+[[nodiscard]] constexpr auto is_official(std::uint8_t opcode, mnemonic m) noexcept -> bool {
+    using enum mnemonic;
+    switch (m) {
+        case unsupported: case i_n: case lax: case sax: case dcp: case isc: case slo: case sre: case rla: case rra:
+            return false;
+        case nop:
+            return opcode == 0xEA;
+        case sbc:
+            return opcode != 0xEB;
+        default:
+            return true;
+    }
+}
+
+struct opcode_entry {
+    std::uint8_t opcode;
+    nes::mnemonic mnemonic;
+    nes::addressing addressing;
+    int cycles;
+};
+
+constexpr auto make_opcode_table(std::initializer_list<opcode_entry> entries) {
+    auto table = std::array<opcode_info, 256>{};
+
+    for (auto [opcode, m, mode, cycles]: entries) {
+        table[opcode] = opcode_info{
+            m,
+            mode,
+            1 + operand_length(mode),
+            cycles,
+            has_page_penalty(m, mode),
+            memory_access_of(m, mode),
+            is_official(opcode, m)};
+    }
+
+    return table;
+}
+
+}// namespace details
+
+// Opcodes missing here are unsupported; the CPU traps on them
+constexpr auto OPCODES = [] {
+    using enum mnemonic;
+    using enum addressing;
+
+    return details::make_opcode_table({
+        {0xEA, nop, imp, 2},
+
+        {0x1A, nop, imp, 2},
+        {0x3A, nop, imp, 2},
+        {0x5A, nop, imp, 2},
+        {0x7A, nop, imp, 2},
+        {0xDA, nop, imp, 2},
+        {0xFA, nop, imp, 2},
+        {0x82, nop, imm, 2},
+        {0xC2, nop, imm, 2},
+        {0xE2, nop, imm, 2},
+
+        {0x04, i_n, zp, 3},
+        {0x44, i_n, zp, 3},
+        {0x64, i_n, zp, 3},
+        {0x0C, i_n, abs, 4},
+
+        {0x14, i_n, zpx, 4},
+        {0x34, i_n, zpx, 4},
+        {0x54, i_n, zpx, 4},
+        {0x74, i_n, zpx, 4},
+        {0xD4, i_n, zpx, 4},
+        {0xF4, i_n, zpx, 4},
+
+        {0x1C, i_n, abx, 4},
+        {0x3C, i_n, abx, 4},
+        {0x5C, i_n, abx, 4},
+        {0x7C, i_n, abx, 4},
+        {0xDC, i_n, abx, 4},
+        {0xFC, i_n, abx, 4},
+
+        {0x80, i_n, imm, 2},
+        {0x89, i_n, imm, 2},
+
+        {0xA7, lax, zp, 3},
+        {0xB7, lax, zpy, 4},
+        {0xAF, lax, abs, 4},
+        {0xBF, lax, aby, 4},
+        {0xA3, lax, izx, 6},
+        {0xB3, lax, izy, 5},
+
+        {0x87, sax, zp, 3},
+        {0x97, sax, zpy, 4},
+        {0x8F, sax, abs, 4},
+        {0x83, sax, izx, 6},
+
+        {0xC7, dcp, zp, 5},
+        {0xD7, dcp, zpx, 6},
+        {0xCF, dcp, abs, 6},
+        {0xDF, dcp, abx, 7},
+        {0xDB, dcp, aby, 7},
+        {0xC3, dcp, izx, 8},
+        {0xD3, dcp, izy, 8},
+
+        {0xE7, isc, zp, 5},
+        {0xF7, isc, zpx, 6},
+        {0xEF, isc, abs, 6},
+        {0xFF, isc, abx, 7},
+        {0xFB, isc, aby, 7},
+        {0xE3, isc, izx, 8},
+        {0xF3, isc, izy, 8},
+
+        {0x07, slo, zp, 5},
+        {0x17, slo, zpx, 6},
+        {0x0F, slo, abs, 6},
+        {0x1F, slo, abx, 7},
+        {0x1B, slo, aby, 7},
+        {0x03, slo, izx, 8},
+        {0x13, slo, izy, 8},
+
+        {0x47, sre, zp, 5},
+        {0x57, sre, zpx, 6},
+        {0x4F, sre, abs, 6},
+        {0x5F, sre, abx, 7},
+        {0x5B, sre, aby, 7},
+        {0x43, sre, izx, 8},
+        {0x53, sre, izy, 8},
+
+        {0x27, rla, zp, 5},
+        {0x37, rla, zpx, 6},
+        {0x2F, rla, abs, 6},
+        {0x3F, rla, abx, 7},
+        {0x3B, rla, aby, 7},
+        {0x23, rla, izx, 8},
+        {0x33, rla, izy, 8},
+
+        {0x67, rra, zp, 5},
+        {0x77, rra, zpx, 6},
+        {0x6F, rra, abs, 6},
+        {0x7F, rra, abx, 7},
+        {0x7B, rra, aby, 7},
+        {0x63, rra, izx, 8},
+        {0x73, rra, izy, 8},
+
+        {0xA9, lda, imm, 2},
+        {0xA5, lda, zp, 3},
+        {0xB5, lda, zpx, 4},
+        {0xAD, lda, abs, 4},
+        {0xBD, lda, abx, 4},
+        {0xB9, lda, aby, 4},
+        {0xA1, lda, izx, 6},
+        {0xB1, lda, izy, 5},
+
+        {0x85, sta, zp, 3},
+        {0x95, sta, zpx, 4},
+        {0x8D, sta, abs, 4},
+        {0x9D, sta, abx, 5},
+        {0x99, sta, aby, 5},
+        {0x81, sta, izx, 6},
+        {0x91, sta, izy, 6},
+
+        {0xA2, ldx, imm, 2},
+        {0xA6, ldx, zp, 3},
+        {0xB6, ldx, zpy, 4},
+        {0xAE, ldx, abs, 4},
+        {0xBE, ldx, aby, 4},
+
+        {0x86, stx, zp, 3},
+        {0x96, stx, zpy, 4},
+        {0x8E, stx, abs, 4},
+
+        {0xA0, ldy, imm, 2},
+        {0xA4, ldy, zp, 3},
+        {0xB4, ldy, zpx, 4},
+        {0xAC, ldy, abs, 4},
+        {0xBC, ldy, abx, 4},
+
+        {0x84, sty, zp, 3},
+        {0x94, sty, zpx, 4},
+        {0x8C, sty, abs, 4},
+
+        {0xAA, tax, imp, 2},
+        {0x8A, txa, imp, 2},
+        {0xA8, tay, imp, 2},
+        {0x98, tya, imp, 2},
+
+        {0xBA, tsx, imp, 2},
+        {0x9A, txs, imp, 2},
+        {0x48, pha, imp, 3},
+        {0x68, pla, imp, 4},
+        {0x08, php, imp, 3},
+        {0x28, plp, imp, 4},
+
+        {0x69, adc, imm, 2},
+        {0x65, adc, zp, 3},
+        {0x75, adc, zpx, 4},
+        {0x6D, adc, abs, 4},
+        {0x7D, adc, abx, 4},
+        {0x79, adc, aby, 4},
+        {0x61, adc, izx, 6},
+        {0x71, adc, izy, 5},
+
+        {0xE9, sbc, imm, 2},
+        {0xEB, sbc, imm, 2},
+        {0xE5, sbc, zp, 3},
+        {0xF5, sbc, zpx, 4},
+        {0xED, sbc, abs, 4},
+        {0xFD, sbc, abx, 4},
+        {0xF9, sbc, aby, 4},
+        {0xE1, sbc, izx, 6},
+        {0xF1, sbc, izy, 5},
+
+        {0xC9, cmp, imm, 2},
+        {0xC5, cmp, zp, 3},
+        {0xD5, cmp, zpx, 4},
+        {0xCD, cmp, abs, 4},
+        {0xDD, cmp, abx, 4},
+        {0xD9, cmp, aby, 4},
+        {0xC1, cmp, izx, 6},
+        {0xD1, cmp, izy, 5},
+
+        {0xE0, cpx, imm, 2},
+        {0xE4, cpx, zp, 3},
+        {0xEC, cpx, abs, 4},
+
+        {0xC0, cpy, imm, 2},
+        {0xC4, cpy, zp, 3},
+        {0xCC, cpy, abs, 4},
+
+        {0xE6, inc, zp, 5},
+        {0xF6, inc, zpx, 6},
+        {0xEE, inc, abs, 6},
+        {0xFE, inc, abx, 7},
+
+        {0xC6, dec, zp, 5},
+        {0xD6, dec, zpx, 6},
+        {0xCE, dec, abs, 6},
+        {0xDE, dec, abx, 7},
+
+        {0xE8, inx, imp, 2},
+        {0xC8, iny, imp, 2},
+
+        {0xCA, dex, imp, 2},
+        {0x88, dey, imp, 2},
+
+        {0x0A, asl, acc, 2},
+        {0x06, asl, zp, 5},
+        {0x16, asl, zpx, 6},
+        {0x0E, asl, abs, 6},
+        {0x1E, asl, abx, 7},
+
+        {0x4A, lsr, acc, 2},
+        {0x46, lsr, zp, 5},
+        {0x56, lsr, zpx, 6},
+        {0x4E, lsr, abs, 6},
+        {0x5E, lsr, abx, 7},
+
+        {0x2A, rol, acc, 2},
+        {0x26, rol, zp, 5},
+        {0x36, rol, zpx, 6},
+        {0x2E, rol, abs, 6},
+        {0x3E, rol, abx, 7},
+
+        {0x6A, ror, acc, 2},
+        {0x66, ror, zp, 5},
+        {0x76, ror, zpx, 6},
+        {0x6E, ror, abs, 6},
+        {0x7E, ror, abx, 7},
+
+        {0x29, ana, imm, 2},
+        {0x25, ana, zp, 3},
+        {0x35, ana, zpx, 4},
+        {0x2D, ana, abs, 4},
+        {0x3D, ana, abx, 4},
+        {0x39, ana, aby, 4},
+        {0x21, ana, izx, 6},
+        {0x31, ana, izy, 5},
+
+        {0x09, ora, imm, 2},
+        {0x05, ora, zp, 3},
+        {0x15, ora, zpx, 4},
+        {0x0D, ora, abs, 4},
+        {0x1D, ora, abx, 4},
+        {0x19, ora, aby, 4},
+        {0x01, ora, izx, 6},
+        {0x11, ora, izy, 5},
+
+        {0x49, eor, imm, 2},
+        {0x45, eor, zp, 3},
+        {0x55, eor, zpx, 4},
+        {0x4D, eor, abs, 4},
+        {0x5D, eor, abx, 4},
+        {0x59, eor, aby, 4},
+        {0x41, eor, izx, 6},
+        {0x51, eor, izy, 5},
+
+        {0x24, bit, zp, 3},
+        {0x2C, bit, abs, 4},
+
+        {0x10, bpl, rel, 2},
+        {0x30, bmi, rel, 2},
+        {0x50, bvc, rel, 2},
+        {0x70, bvs, rel, 2},
+        {0x90, bcc, rel, 2},
+        {0xB0, bcs, rel, 2},
+        {0xD0, bne, rel, 2},
+        {0xF0, beq, rel, 2},
+
+        {0x18, clc, imp, 2},
+        {0x38, sec, imp, 2},
+        {0xD8, cld, imp, 2},
+        {0xF8, sed, imp, 2},
+        {0x58, cli, imp, 2},
+        {0x78, sei, imp, 2},
+        {0xB8, clv, imp, 2},
+
+        {0x4C, jmp, abs, 3},
+        {0x6C, jmp, ind, 5},
+        {0x20, jsr, abs, 6},
+        {0x60, rts, imp, 6},
+        {0x40, rti, imp, 6},
+        {0x00, brk, imp, 7}
+    });
+}();
+
+// What the CPU does with the bus on a cycle. It reads or writes on every
+// one; reads it has no use for are only made where they can be observed
+enum class bus_cycle : std::uint8_t {
+    read,
+    write
+};
+
+struct bus_schedule {
+    std::array<bus_cycle, 8> cycles{};
+    int length{0};
+
+    constexpr void add(bus_cycle cycle, int count = 1) noexcept {
+        for (auto i = 0; i < count; ++i)
+            cycles[static_cast<std::size_t>(length++)] = cycle;
+    }
+};
+
+// The instruction cycle by cycle, opcode fetch included, when it crosses
+// no page and takes no branch: the penalty cycles come at the end
+[[nodiscard]] constexpr auto bus_cycles(const opcode_info& info) noexcept -> bus_schedule {
+    using enum bus_cycle;
+    using enum mnemonic;
+
+    auto schedule = bus_schedule{};
+    schedule.add(read);
+
+    switch (info.mnemonic) {
+        case unsupported:
+            return schedule;
+        case brk:
+            schedule.add(read);
+            schedule.add(write, 3);
+            schedule.add(read, 2);
+            return schedule;
+        case jsr:
+            schedule.add(read, 3);
+            schedule.add(write, 2);
+            return schedule;
+        case pha: case php:
+            schedule.add(read);
+            schedule.add(write);
+            return schedule;
+        case pla: case plp:
+            schedule.add(read, 3);
+            return schedule;
+        case rts: case rti:
+            schedule.add(read, 5);
+            return schedule;
+        default:
+            break;
+    }
+
+    switch (info.addressing) {
+        case addressing::imp: case addressing::acc: case addressing::imm: case addressing::rel:
+            schedule.add(read);
+            return schedule;
+        case addressing::ind:
+            schedule.add(read, 4);
+            return schedule;
+        case addressing::zp:
+            schedule.add(read);
+            break;
+        case addressing::zpx: case addressing::zpy: case addressing::abs:
+            schedule.add(read, 2);
+            break;
+        case addressing::abx: case addressing::aby:
+            // Indexing reads from the address before the carry into the high
+            // byte; only a read that crossed no page can stop there
+            schedule.add(read, info.access == memory_access::read ? 2 : 3);
+            break;
+        case addressing::izx:
+            schedule.add(read, 4);
+            break;
+        case addressing::izy:
+            schedule.add(read, info.access == memory_access::read ? 3 : 4);
+            break;
+    }
+
+    switch (info.access) {
+        case memory_access::write:
+            schedule.add(write);
+            break;
+        case memory_access::read_modify_write:
+            // The value read is written back unchanged before the result is
+            schedule.add(read);
+            schedule.add(write, 2);
+            break;
+        default:
+            if (info.mnemonic != jmp)
+                schedule.add(read);
+            break;
+    }
+
+    return schedule;
+}
+
+static_assert([] {
+    for (const auto& info: OPCODES) {
+        if (info.mnemonic != mnemonic::unsupported and bus_cycles(info).length != info.cycles)
+            return false;
+    }
+    return true;
+}(), "the bus schedules disagree with the opcode table");
+
+}// namespace nes
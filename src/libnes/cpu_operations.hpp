@@ -21,13 +21,6 @@ inline auto is_page_crossed(std::uint16_t base, std::uint16_t effective_address)
     return (base & 0xFF00u) != (effective_address & 0xFF00u);
 }
 
-inline auto index(std::uint16_t base, std::int16_t offset) {
-    const std::uint16_t address = int(base) + offset;
-    auto additional_cycles = is_page_crossed(base, address) ? 1 : 0;
-
-    return std::tuple{address, additional_cycles};
-}
-
 inline auto arith_result(int x) {
     auto c = (x / 0x100) != 0;
     auto r = static_cast<std::uint8_t>(x % 0x100);
@@ -48,8 +41,7 @@ inline void adc_impl(auto& result, std::uint8_t accum, std::uint8_t operand, fla
 }
 
 inline void cmp_impl(std::uint8_t accum, std::uint8_t operand, flags_register& flags) {
-    auto alu_result = arith_register{flags};
-    alu_result.assign(accum - operand);
+    flags.set_nz(static_cast<std::uint8_t>(accum - operand));
     flags.set(cpu_flag::carry, accum >= operand);
 }
 
@@ -96,10 +88,10 @@ const auto inc = [](auto& cpu, auto address_mode) {
     auto am = address_mode;
     auto [operand, _] = am.load_operand();
 
-    auto alu_result = arith_register{cpu.p};
-    alu_result.assign(operand + 1);
+    auto result = static_cast<std::uint8_t>(operand + 1);
+    cpu.p.set_nz(result);
 
-    am.store_operand(alu_result.value());
+    am.store_operand(result);
     return 0;
 };
 
@@ -107,10 +99,10 @@ const auto dec = [](auto& cpu, auto address_mode) {
     auto am = address_mode;
     auto [operand, _] = am.load_operand();
 
-    auto alu_result = arith_register{cpu.p};
-    alu_result.assign(operand - 1);
+    auto result = static_cast<std::uint8_t>(operand - 1);
+    cpu.p.set_nz(result);
 
-    am.store_operand(alu_result.value());
+    am.store_operand(result);
     return 0;
 };
 
@@ -189,10 +181,10 @@ const auto eor = [](auto& cpu, auto address_mode) {
 const auto bit = [](auto& cpu, auto address_mode) {
     auto [operand, additional_cycles] = address_mode.load_operand();
 
-    [[maybe_unused]] auto alu_result = arith_register{cpu.p};
-    alu_result.assign(cpu.a.value() & operand);
+    // Z comes from A & M but N straight from bit 7 of M, which the high
+    // byte of the recorded result carries
+    cpu.p.set_nz(static_cast<std::uint16_t>((cpu.a.value() & operand) | ((operand & 0x80) << 8)));
     cpu.p.set(cpu_flag::overflow, operand & (1 << 6));
-    cpu.p.set(cpu_flag::negative, operand & (1 << 7));
 
     return additional_cycles;
 };
@@ -258,22 +250,25 @@ const auto tya = [](auto& cpu, auto) {
 };
 
 const auto pha = [](auto& cpu, auto) {
-    cpu.write(cpu.s.push(), cpu.a.value());
+    cpu.push(cpu.a.value());
     return 0;
 };
 
+// Pulling takes a cycle to move the stack pointer before the read
 const auto pla = [](auto& cpu, auto) {
-    cpu.a = cpu.read(cpu.s.pop());
+    cpu.idle_cycle();
+    cpu.a = cpu.pop();
     return 0;
 };
 
 const auto php = [](auto& cpu, auto) {
-    cpu.write(cpu.s.push(), cpu.p.value());
+    cpu.push(cpu.p.value());
     return 0;
 };
 
 const auto plp = [](auto& cpu, auto) {
-    auto flags_value = cpu.read(cpu.s.pop());
+    cpu.idle_cycle();
+    auto flags_value = cpu.pop();
     cpu.p.assign(flags_value & 0xEF);
     return 0;
 };
@@ -393,19 +388,22 @@ const auto jmp = [](auto& cpu, auto address_mode) {
 
 const auto jsr = [](auto& cpu, auto address_mode) {
     auto [address, _] = address_mode.fetch_address();
+    cpu.idle_cycle();
     auto prev_pc = nes::program_counter{static_cast<std::uint16_t>(cpu.pc.value() - 1)};
-    cpu.write(cpu.s.push(), prev_pc.hi());
-    cpu.write(cpu.s.push(), prev_pc.lo());
+    cpu.push(prev_pc.hi());
+    cpu.push(prev_pc.lo());
     cpu.pc.assign(address);
 
     return 0;
 };
 
 const auto rts = [](auto& cpu, auto) {
-    auto lo = cpu.read(cpu.s.pop());
-    auto hi = cpu.read(cpu.s.pop());
+    cpu.idle_cycle();
+    auto lo = cpu.pop();
+    auto hi = cpu.pop();
     auto address = static_cast<std::uint16_t>((hi << 8) | lo);
     cpu.pc.assign(address + 1);
+    cpu.idle_cycle();
 
     return 0;
 };
@@ -413,37 +411,31 @@ const auto rts = [](auto& cpu, auto) {
 const auto rti = [](auto& cpu, auto _) {
     plp(cpu, _);
 
-    auto lo = cpu.read(cpu.s.pop());
-    auto hi = cpu.read(cpu.s.pop());
+    auto lo = cpu.pop();
+    auto hi = cpu.pop();
     auto address = static_cast<std::uint16_t>((hi << 8) | lo);
     cpu.pc.assign(address);
 
     return 0;
 };
 
-template <class cpu_t>
-struct reset_vector {
-    explicit reset_vector(cpu_t& c)
-        : cpu(c) {}
-
-    cpu_t& cpu;
-
-    auto fetch_address() {
-        return std::tuple{cpu.read_word(0xFFFE), 0};
-    }
-};
-
+// Pushes the return address and the flags, as JSR and PHP would, and only
+// then reads the vector -- which an NMI may have hijacked
 const auto brk = [](auto& cpu, auto _) {
-    jsr(cpu, reset_vector{cpu});
+    auto prev_pc = nes::program_counter{static_cast<std::uint16_t>(cpu.pc.value() - 1)};
+    cpu.push(prev_pc.hi());
+    cpu.push(prev_pc.lo());
     php(cpu, _);
+    cpu.pc.assign(cpu.read_word(cpu.interrupt_vector(0xFFFE)));
     cpu.p.set(cpu_flag::break_called);
     cpu.p.set(cpu_flag::int_disable);
 
     return 0;
 };
 
+// Reads its operand all the same
 const auto i_n = [](auto&, auto address_mode) {
-    auto [_, additional_cycles] = address_mode.fetch_address();
+    auto [_, additional_cycles] = address_mode.load_operand();
     return additional_cycles;
 };
 
@@ -462,12 +454,12 @@ const auto isc = [](auto& cpu, auto address_mode) {
     auto am = address_mode;
     auto [operand, _] = am.load_operand();
 
-    auto alu_result = arith_register{cpu.p};
-    alu_result.assign(operand + 1);
+    auto result = static_cast<std::uint8_t>(operand + 1);
+    cpu.p.set_nz(result);
 
-    am.store_operand(alu_result.value());
+    am.store_operand(result);
 
-    adc_impl(cpu.a, cpu.a.value(), 0xFF - alu_result.value(), cpu.p);
+    adc_impl(cpu.a, cpu.a.value(), 0xFF - result, cpu.p);
     return 0;
 };
 
@@ -475,12 +467,12 @@ const auto dcp = [](auto& cpu, auto address_mode) {
     auto am = address_mode;
     auto [operand, _] = am.load_operand();
 
-    auto alu_result = arith_register{cpu.p};
-    alu_result.assign(operand - 1);
+    auto result = static_cast<std::uint8_t>(operand - 1);
+    cpu.p.set_nz(result);
 
-    am.store_operand(alu_result.value());
+    am.store_operand(result);
 
-    cmp_impl(cpu.a.value(), alu_result.value(), cpu.p);
+    cmp_impl(cpu.a.value(), result, cpu.p);
     return 0;
 };
 
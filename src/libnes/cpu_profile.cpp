@@ -0,0 +1,103 @@
+#include <libnes/cpu_profile.hpp>
+
+#include <libnes/cpu_opcodes.hpp>
+
+#include <algorithm>
+#include <format>
+
+namespace nes
+{
+
+auto cpu_profile::at(std::uint16_t address) const noexcept -> counters {
+    auto sum = counters{};
+    for (const auto& bank: banks_) {
+        if (bank.page != address >> 8)
+            continue;
+
+        const auto& c = bank.at[address & 0xFF];
+        sum.instructions += c.instructions;
+        sum.cycles += c.cycles;
+    }
+    return sum;
+}
+
+void cpu_profile::clear() noexcept {
+    banks_.clear();
+    last_bank_.fill(0);
+    opcodes_.fill(counters{});
+}
+
+// Bank switches are rare next to the instructions run, so a linear search
+// is enough
+auto cpu_profile::find_bank(std::uint8_t page, const std::uint8_t* memory) -> std::size_t {
+    auto found = std::ranges::find_if(banks_, [&](const auto& b) { return b.page == page and b.memory == memory; });
+    if (found != banks_.end())
+        return static_cast<std::size_t>(found - banks_.begin());
+
+    auto number = static_cast<int>(std::ranges::count_if(banks_, [&](const auto& b) { return b.page == page; }));
+    banks_.push_back(bank{page, memory, number, {}, {}});
+    return banks_.size() - 1;
+}
+
+void cpu_profile::write_csv(std::ostream& out) const {
+    out << "kind,bank,address,opcode,mnemonic,instructions,cycles\n";
+
+    for (auto opcode = 0; opcode < 0x100; ++opcode) {
+        const auto& c = opcodes_[opcode];
+        if (c.instructions == 0)
+            continue;
+
+        out << std::format(
+            "opcode,,,{:02X},{},{},{}\n",
+            opcode, name(OPCODES[opcode].mnemonic), c.instructions, c.cycles);
+    }
+
+    for (const auto& bank: banks_) {
+        for (auto offset = 0; offset < 0x100; ++offset) {
+            const auto& c = bank.at[offset];
+            if (c.instructions == 0)
+                continue;
+
+            out << std::format(
+                "address,{},{:04X},{:02X},{},{},{}\n",
+                bank.number, bank.page * 0x100 + offset, bank.opcode[offset],
+                name(OPCODES[bank.opcode[offset]].mnemonic), c.instructions, c.cycles);
+        }
+    }
+}
+
+void cpu_profile::write_json(std::ostream& out) const {
+    auto separator = "";
+
+    out << "{\n  \"opcodes\": [";
+    for (auto opcode = 0; opcode < 0x100; ++opcode) {
+        const auto& c = opcodes_[opcode];
+        if (c.instructions == 0)
+            continue;
+
+        out << std::format(
+            "{}\n    {{\"opcode\": \"{:02X}\", \"mnemonic\": \"{}\", \"instructions\": {}, \"cycles\": {}}}",
+            separator, opcode, name(OPCODES[opcode].mnemonic), c.instructions, c.cycles);
+        separator = ",";
+    }
+
+    separator = "";
+    out << "\n  ],\n  \"addresses\": [";
+    for (const auto& bank: banks_) {
+        for (auto offset = 0; offset < 0x100; ++offset) {
+            const auto& c = bank.at[offset];
+            if (c.instructions == 0)
+                continue;
+
+            out << std::format(
+                "{}\n    {{\"bank\": {}, \"address\": \"{:04X}\", \"opcode\": \"{:02X}\", \"mnemonic\": \"{}\", "
+                "\"instructions\": {}, \"cycles\": {}}}",
+                separator, bank.number, bank.page * 0x100 + offset, bank.opcode[offset],
+                name(OPCODES[bank.opcode[offset]].mnemonic), c.instructions, c.cycles);
+            separator = ",";
+        }
+    }
+    out << "\n  ]\n}\n";
+}
+
+}// namespace nes
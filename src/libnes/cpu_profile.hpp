@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace nes
+{
+
+// Where the guest code spends its time: the instructions run and the cycles
+// they took, per opcode and per address. The same address in different
+// banks counts apart, the bank being told by the memory mapped there
+class cpu_profile
+{
+public:
+    struct counters {
+        std::uint64_t instructions{0};
+        std::uint64_t cycles{0};
+    };
+
+    // `memory` is what the bus has mapped at the address's page, nullptr if
+    // it doesn't say
+    void record(const std::uint8_t* memory, std::uint16_t address, std::uint8_t opcode, int cycles) {
+        auto page = address >> 8;
+        auto& slot = last_bank_[page];
+        if (slot == 0 or banks_[slot - 1].memory != memory)
+            slot = find_bank(static_cast<std::uint8_t>(page), memory) + 1;
+
+        auto& bank = banks_[slot - 1];
+        bank.opcode[address & 0xFF] = opcode;
+        count(bank.at[address & 0xFF], cycles);
+        count(opcodes_[opcode], cycles);
+    }
+
+    [[nodiscard]] auto of_opcode(std::uint8_t opcode) const noexcept -> const counters& { return opcodes_[opcode]; }
+
+    // The counters of the address summed over its banks
+    [[nodiscard]] auto at(std::uint16_t address) const noexcept -> counters;
+
+    void clear() noexcept;
+
+    // One row per address (and bank) or opcode run. Banks are numbered per
+    // page, in the order they were first run from
+    void write_csv(std::ostream& out) const;
+    void write_json(std::ostream& out) const;
+
+private:
+    static void count(counters& c, int cycles) noexcept {
+        c.instructions += 1;
+        c.cycles += static_cast<std::uint64_t>(cycles);
+    }
+
+    auto find_bank(std::uint8_t page, const std::uint8_t* memory) -> std::size_t;
+
+    struct bank {
+        std::uint8_t page;
+        const std::uint8_t* memory;
+        int number;
+        std::array<counters, 0x100> at;
+        std::array<std::uint8_t, 0x100> opcode;
+    };
+
+    std::vector<bank> banks_;
+    std::array<std::size_t, 0x100> last_bank_{};// per page, 1 + the index of the bank last run, 0 if none
+    std::array<counters, 0x100> opcodes_{};
+};
+
+}// namespace nes
@@ -18,20 +18,62 @@ enum class cpu_flag {
     negative = 7
 };
 
+// N and Z are evaluated lazily: instead of updating two bits on every ALU
+// operation, the register records the last result and only derives the
+// flags when something reads them. A result reads as Z when its low byte
+// is zero and as N when bit 7 or bit 15 is set; the high byte lets
+// explicit writes (PLP, RTI, BIT) encode combinations no single byte can,
+// such as N and Z both set.
 class flags_register
 {
     constexpr static auto pos(cpu_flag f) { return static_cast<size_t>(f); }
 
+    [[nodiscard]] constexpr static auto nz_result(bool zero, bool negative) -> std::uint16_t {
+        return static_cast<std::uint16_t>((zero ? 0x0000u : 0x0001u) | (negative ? 0x8000u : 0x0000u));
+    }
+
 public:
-    void assign(std::uint8_t bits) { bits_ = bits | 0x20u; }
-    void set(cpu_flag f, bool value = true) { bits_.set(pos(f), value); }
-    void reset(cpu_flag f) { bits_.reset(pos(f)); }
+    void assign(std::uint8_t bits) {
+        bits_ = bits | 0x20u;
+        nz_ = nz_result((bits & 0x02u) != 0, (bits & 0x80u) != 0);
+    }
+
+    void set(cpu_flag f, bool value = true) {
+        if (f == cpu_flag::zero)
+            nz_ = nz_result(value, test(cpu_flag::negative));
+        else if (f == cpu_flag::negative)
+            nz_ = nz_result(test(cpu_flag::zero), value);
+        else
+            bits_.set(pos(f), value);
+    }
+
+    void reset(cpu_flag f) { set(f, false); }
 
-    [[nodiscard]] auto test(cpu_flag f) const { return bits_.test(pos(f)); }
-    [[nodiscard]] auto value() const { return static_cast<std::uint8_t>(bits_.to_ulong()); }
+    // Records the result N and Z are derived from
+    void set_nz(std::uint16_t result) { nz_ = result; }
+
+    [[nodiscard]] auto test(cpu_flag f) const -> bool {
+        if (f == cpu_flag::zero)
+            return (nz_ & 0x00FFu) == 0;
+        if (f == cpu_flag::negative)
+            return (nz_ & 0x8080u) != 0;
+
+        return bits_.test(pos(f));
+    }
+
+    [[nodiscard]] auto value() const {
+        auto bits = bits_.to_ulong() & ~0x82ul;
+        if (test(cpu_flag::zero))
+            bits |= 0x02ul;
+        if (test(cpu_flag::negative))
+            bits |= 0x80ul;
+
+        return static_cast<std::uint8_t>(bits);
+    }
 
 private:
     std::bitset<8> bits_{0x20};
+    std::uint16_t nz_{nz_result(false, false)};
 };
 
 class arith_register
@@ -49,8 +91,7 @@ public:
 
     void assign(std::uint8_t new_val) {
         val_ = new_val;
-        flags_.set(cpu_flag::zero, val_ == 0);
-        flags_.set(cpu_flag::negative, (val_ & 0x80u) != 0);
+        flags_.set_nz(val_);
     }
 
 private:
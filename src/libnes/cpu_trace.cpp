@@ -0,0 +1,67 @@
+#include <libnes/cpu_trace.hpp>
+
+#include <libnes/cpu_disassembler.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+namespace nes
+{
+
+// Drains the ring into the file until asked to stop, and then once more
+struct trace_recorder::writer {
+    writer(trace_recorder& recorder, const std::string& filename)
+        : file{filename, std::ofstream::binary}
+        , thread{[this, &recorder](std::stop_token stop) { drain(recorder, stop); }} {
+        if (not file)
+            throw std::runtime_error("Can't open trace file " + filename);
+    }
+
+    void drain(trace_recorder& recorder, const std::stop_token& stop) {
+        for (;;) {
+            auto stopping = stop.stop_requested();
+            auto tail = recorder.tail_.load(std::memory_order_relaxed);
+            auto head = recorder.head_.load(std::memory_order_acquire);
+
+            if (head == tail) {
+                if (stopping)
+                    return;
+
+                std::this_thread::sleep_for(1ms);
+                continue;
+            }
+
+            // As far as the end of the ring at a time
+            auto first = tail & recorder.mask_;
+            auto count = std::min(head - tail, recorder.ring_.size() - first);
+            file.write(reinterpret_cast<const char*>(&recorder.ring_[first]), static_cast<std::streamsize>(count * sizeof(trace_record)));
+
+            recorder.tail_.store(tail + count, std::memory_order_release);
+        }
+    }
+
+    std::ofstream file;
+    std::jthread thread;// last: stopped and joined before the file closes
+};
+
+trace_recorder::trace_recorder(const std::string& filename, std::size_t capacity)
+    : ring_(std::bit_ceil(std::max(capacity, std::size_t{1})))
+    , mask_{ring_.size() - 1}
+    , writer_{std::make_unique<writer>(*this, filename)} {
+}
+
+trace_recorder::~trace_recorder() = default;
+
+void write_nestest_log(std::istream& trace, std::ostream& log) {
+    auto record = trace_record{};
+    while (trace.read(reinterpret_cast<char*>(&record), sizeof(record)))
+        log << trace_line(record, record.bytes) << '\n';
+}
+
+}// namespace nes
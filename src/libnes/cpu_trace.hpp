@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace nes
+{
+
+// An instruction as the CPU was about to run it: where it was, its bytes,
+// the registers it started with and the cycle it started on. Trace files
+// are these records back to back, in host byte order
+struct trace_record {
+    std::uint64_t cycle;
+    std::uint16_t pc;
+    std::array<std::uint8_t, 3> bytes;// the opcode and the operand bytes after it
+    std::uint8_t a;
+    std::uint8_t x;
+    std::uint8_t y;
+    std::uint8_t p;
+    std::uint8_t s;
+    std::array<std::uint8_t, 6> reserved{};
+};
+
+static_assert(sizeof(trace_record) == 24);
+static_assert(std::is_trivially_copyable_v<trace_record>);
+
+// Writes the records it's handed to a file, from a thread of its own. They
+// get there through a ring buffer neither side locks, and the emulation
+// never waits on the file: records that find the ring full are dropped,
+// and counted
+class trace_recorder
+{
+public:
+    static constexpr std::size_t DEFAULT_CAPACITY = std::size_t{1} << 20;
+
+    // Throws std::runtime_error if the file can't be opened
+    explicit trace_recorder(const std::string& filename, std::size_t capacity = DEFAULT_CAPACITY);
+
+    // Writes out whatever is still in the ring
+    ~trace_recorder();
+
+    trace_recorder(const trace_recorder&) = delete;
+    trace_recorder& operator=(const trace_recorder&) = delete;
+
+    // From one thread only
+    void record(const trace_record& r) noexcept {
+        auto head = head_.load(std::memory_order_relaxed);
+        if (head - tail_seen_ == ring_.size()) {
+            tail_seen_ = tail_.load(std::memory_order_acquire);
+            if (head - tail_seen_ == ring_.size()) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        ring_[head & mask_] = r;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    [[nodiscard]] auto dropped() const noexcept -> std::uint64_t { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct writer;
+    friend struct writer;
+
+    std::vector<trace_record> ring_;
+    std::uint64_t mask_;
+
+    // The recording side; it only looks at where the writer has got to
+    // again when the ring seems full
+    std::atomic<std::uint64_t> head_{0};
+    std::uint64_t tail_seen_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+
+    std::atomic<std::uint64_t> tail_{0};
+    std::unique_ptr<writer> writer_;
+};
+
+// Rewrites a trace file as nestest.log has it, one line per instruction
+void write_nestest_log(std::istream& trace, std::ostream& log);
+
+}// namespace nes
@@ -1,10 +1,13 @@
 #pragma once
 
 #include <libnes/cartridge.hpp>
+#include <libnes/chr_tile_cache.hpp>
 #include <libnes/ppu_name_table.hpp>
 
 #include <array>
 #include <cassert>
+#include <cstdint>
+#include <limits>
 #include <optional>
 #include <utility>
 #include <vector>
@@ -66,6 +69,10 @@ public:
             // bank-select lines; without banks chr_bank() would divide by zero
             chr_.resize(2);
         }
+
+        chr_tiles_.reserve(chr_.size());
+        for (const auto& bank: chr_)
+            chr_tiles_.emplace_back(bank);
     }
 
     [[nodiscard]] auto chr_read(std::uint16_t addr) const noexcept -> std::uint8_t override {
@@ -76,7 +83,13 @@ public:
         if (not chr_is_ram_)
             return;// real CHR-ROM boards ignore writes
 
-        chr_[chr_bank(addr)][addr % 0x1000] = value;
+        auto bank = chr_bank(addr);
+        chr_[bank][addr % 0x1000] = value;
+        chr_tiles_[bank].update(chr_[bank], addr % 0x1000);
+    }
+
+    [[nodiscard]] auto chr_row(std::uint16_t addr) const noexcept -> std::span<const std::uint8_t, 8> override {
+        return chr_tiles_[chr_bank(addr)].row(addr % 0x1000);
     }
 
     [[nodiscard]] auto mirroring() const noexcept -> name_table_mirroring override {
@@ -92,6 +105,12 @@ public:
         if (addr < 0x8000)
             return false;
 
+        // Takes one write a cycle apart from the last at most: the second
+        // of the two a read-modify-write makes never gets to the register
+        if (write_cycle() == ignored_write_cycle_)
+            return false;
+        ignored_write_cycle_ = write_cycle() + 1;
+
         shift_register_.load(value);
         if (auto r = shift_register_.get_value(); r.has_value()) {
             if (addr < 0xA000) {
@@ -116,6 +135,45 @@ public:
             return prg_ram_[addr - 0x6000];
         }
 
+        if (auto prg = prg_rom(addr); prg != nullptr)
+            return *prg;
+
+        return std::nullopt;
+    }
+
+    [[nodiscard]] auto read_page(std::uint8_t page) -> const std::uint8_t* override {
+        if (page >= 0x80)
+            return prg_rom(static_cast<std::uint16_t>(page << 8));
+
+        return write_page(page);
+    }
+
+    [[nodiscard]] auto write_page(std::uint8_t page) -> std::uint8_t* override {
+        if (page >= 0x60 and page < 0x80)
+            return prg_ram_.data() + ((page - 0x60) << 8);
+
+        return nullptr;
+    }
+
+    constexpr void set_mirroring() noexcept {
+        switch (control_ & 0b00011) {
+            case 0b00:
+                mirroring_ = name_table_mirroring::single_screen_lo;
+                break;
+            case 0b01:
+                mirroring_ = name_table_mirroring::single_screen_hi;
+                break;
+            case 0b10:
+                mirroring_ = name_table_mirroring::vertical;
+                break;
+            case 0b11:
+                mirroring_ = name_table_mirroring::horizontal;
+                break;
+        }
+    }
+
+private:
+    [[nodiscard]] auto prg_rom(std::uint16_t addr) const -> const std::uint8_t* {
         auto prg_mode = (control_ & 0b01100) >> 2;
 
         if (prg_mode == 0 or prg_mode == 1) {
@@ -126,7 +184,7 @@ public:
             auto ix = (prg_ix_ * 2) + prg_offset;
             auto& prg = prg_[ix];
 
-            return prg[address];
+            return &prg[address];
         }
 
         if (addr >= 0x8000 and addr <= 0xBFFF) {
@@ -135,7 +193,7 @@ public:
                 ? prg_[prg_ix_ % prg_.size()]
                 : prg_.front();
 
-            return prg[address];
+            return &prg[address];
         }
 
         if (addr >= 0xC000 and addr <= 0xFFFF) {
@@ -144,30 +202,12 @@ public:
                 ? prg_.back()
                 : prg_[prg_ix_ % prg_.size()];
 
-            return prg[address];
+            return &prg[address];
         }
 
-        return std::nullopt;
-    }
-
-    constexpr void set_mirroring() noexcept {
-        switch (control_ & 0b00011) {
-            case 0b00:
-                mirroring_ = name_table_mirroring::single_screen_lo;
-                break;
-            case 0b01:
-                mirroring_ = name_table_mirroring::single_screen_hi;
-                break;
-            case 0b10:
-                mirroring_ = name_table_mirroring::vertical;
-                break;
-            case 0b11:
-                mirroring_ = name_table_mirroring::horizontal;
-                break;
-        }
+        return nullptr;
     }
 
-private:
     // In 4Kb mode (control bit 4 set) the $0000 and $1000 pattern-table
     // windows each have their own bank select; in 8Kb mode a single select
     // (low bit ignored) maps a bank pair across both windows
@@ -183,10 +223,12 @@ private:
 
     std::vector<std::array<std::uint8_t, 16_Kb>> prg_;
     std::vector<membank<4_Kb>> chr_;
+    std::vector<chr_tile_cache> chr_tiles_;// decoded, bank for bank
     bool chr_is_ram_{false};
     std::array<std::uint8_t, 8_Kb> prg_ram_{};
 
     mmc1_shift_register shift_register_;
+    std::uint64_t ignored_write_cycle_{std::numeric_limits<std::uint64_t>::max()};
     std::uint8_t control_{0x0C};
     std::uint8_t chr_ix0_{0};
     std::uint8_t chr_ix1_{0};
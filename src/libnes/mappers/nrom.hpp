@@ -1,6 +1,7 @@
 #pragma once
 
 #include <libnes/cartridge.hpp>
+#include <libnes/chr_tile_cache.hpp>
 #include <libnes/ppu_name_table.hpp>
 
 #include <array>
@@ -17,6 +18,8 @@ public:
         : prg_{std::move(prg)}
         , chr0_{chr0}
         , chr1_{chr1}
+        , chr0_tiles_{chr0_}
+        , chr1_tiles_{chr1_}
         , mirroring_{mirroring} {}
 
     [[nodiscard]] auto mirroring() const noexcept -> name_table_mirroring override { return mirroring_; }
@@ -26,6 +29,11 @@ public:
         return chr[addr % 0x1000];
     }
 
+    [[nodiscard]] auto chr_row(std::uint16_t addr) const noexcept -> std::span<const std::uint8_t, 8> override {
+        auto& tiles = (addr < 0x1000) ? chr0_tiles_ : chr1_tiles_;
+        return tiles.row(addr % 0x1000);
+    }
+
     auto write([[maybe_unused]] std::uint16_t addr, [[maybe_unused]] std::uint8_t value) -> bool override {
         return false;
     }
@@ -52,10 +60,20 @@ public:
         return std::nullopt;
     }
 
+    [[nodiscard]] auto read_page(std::uint8_t page) -> const std::uint8_t* override {
+        if (page < 0x80)
+            return nullptr;
+
+        auto& prg = (page < 0xC0) ? prg_.front() : prg_.back();
+        return prg.data() + ((page << 8) & 0x3FFFu);
+    }
+
 private:
     std::vector<std::array<std::uint8_t, 16_Kb>> prg_;
     membank<4_Kb> chr0_;
     membank<4_Kb> chr1_;
+    chr_tile_cache chr0_tiles_;
+    chr_tile_cache chr1_tiles_;
     name_table_mirroring mirroring_;
 };
 
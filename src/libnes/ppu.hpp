@@ -1,5 +1,6 @@
 #pragma once
 
+#include <libnes/cpu_interrupts.hpp>
 #include <libnes/ppu_crt_scan.hpp>
 #include <libnes/ppu_name_table.hpp>
 #include <libnes/ppu_object_attribute_memory.hpp>
@@ -11,9 +12,11 @@
 
 #include "cartridge.hpp"
 #include "ppu_registers.hpp"
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <optional>
+#include <utility>
 
 namespace nes
 {
@@ -23,32 +26,73 @@ constexpr auto VERTICAL_BLANK_SCANLINES = 20;
 constexpr auto POST_RENDER_SCANLINES = 1;
 constexpr auto SCANLINE_DOTS = 341;
 
-class ppu
+// The PPU reads CHR and asks for the mirroring on every fetched pixel, so it
+// is parameterized on the cartridge type: over a concrete mapper those calls
+// resolve statically and inline
+template <class cartridge_t = cartridge>
+class basic_ppu
 {
 public:
     template <class container_t>
-    ppu(const container_t& system_color_palette)
+    basic_ppu(const container_t& system_color_palette)
         : palette_table_{system_color_palette} {}
 
-    constexpr void load_cartridge(cartridge* rom) noexcept { cartridge_ = rom; }
+    constexpr void load_cartridge(cartridge_t* rom) noexcept { cartridge_ = rom; }
     constexpr void eject_cartridge() noexcept { load_cartridge(nullptr); }
 
+    // Where the PPU raises its NMI, on the edges of the vblank flag ANDed
+    // with the NMI enable bit
+    constexpr void connect(interrupt_lines* lines) noexcept { interrupts_ = lines; }
+
     control_register control;
     std::uint8_t status{0};
     std::uint8_t mask{0};
 
     scroll_registers scroll_;
 
-    bool nmi_raised{false};
-    bool nmi_seen{false};
-
     template <screen screen_t>
     constexpr void tick_old(screen_t& screen);
 
     template <screen screen_t>
     constexpr void tick(screen_t& screen);
 
+    // Runs `dots` dots at most and returns how many it ran. Dots that take
+    // in a visible line's every pixel have no register write landing among
+    // them, so the line is drawn in one pass, fetching each tile once; any
+    // other dot runs on its own, as tick_old runs it
+    template <screen screen_t>
+    constexpr auto run_old(screen_t& screen, std::uint64_t dots) -> int;
+
     [[nodiscard]] constexpr auto is_frame_ready() const noexcept { return scan_.is_frame_finished(); }
+    [[nodiscard]] constexpr auto frame_dots() const noexcept { return scan_.frame_dots(); }
+
+    // Dots left until the vblank flag is next set or cleared -- the only
+    // points where the NMI line moves without a register access
+    [[nodiscard]] constexpr auto dots_until_vblank_edge() const noexcept {
+        return std::min(
+            scan_.dots_until(VISIBLE_SCANLINES + POST_RENDER_SCANLINES, 1),
+            scan_.dots_until(-1, 1)
+        );
+    }
+
+    // Dots left until the status register may next change without a
+    // register access: at a vblank edge, or once sprite 0 may hit
+    [[nodiscard]] constexpr auto dots_until_status_change() const noexcept {
+        auto dots = dots_until_vblank_edge();
+        if ((status & 0x40) != 0 or not show_background() or not show_sprites())
+            return dots;
+
+        // OAM Y is the sprite's top row minus 1
+        auto top = oam_.sprites[0].y + 1;
+        auto height = control.sprite_size() == sprite_size::sprite8x8 ? 8 : 16;
+
+        if (top >= VISIBLE_SCANLINES or scan_.line() >= top + height)
+            return dots;
+        if (scan_.line() >= top)
+            return 0;
+
+        return std::min(dots, scan_.dots_until(top, 0));
+    }
 
     [[nodiscard]] constexpr auto read(std::uint16_t addr) -> std::optional<std::uint8_t> {
         switch (addr) {
@@ -73,12 +117,13 @@ public:
                 // immediate NMI on real hardware (edge-triggered on the AND
                 // of the flag and the enable bit)
                 if (not nmi_was_enabled and control.raise_vblank_nmi() and (status & 0x80) != 0) {
-                    nmi_raised = true;
+                    raise_nmi();
                 }
                 return;
             }
             case 0x2001: {
                 mask = value;
+                palette_table_.set_mask(value);
                 return;
             }
             case 0x2003: {
@@ -165,6 +210,11 @@ public:
     }
 
 private:
+    constexpr void raise_nmi() noexcept {
+        if (interrupts_ != nullptr)
+            interrupts_->raise_nmi();
+    }
+
     // Scroll as the OLD renderer consumes it, latched from `staged` at the
     // hardware copy points (dot 257 for X, pre-render 280-304 for Y). The
     // old path models scroll as absolute per-frame offsets, so it must not
@@ -223,6 +273,11 @@ private:
         return cartridge_->chr_read(addr);
     }
 
+    [[nodiscard]] constexpr auto read_chr_row(std::uint16_t addr) const {
+        assert(addr < 0x2000);
+        return cartridge_->chr_row(addr);
+    }
+
     constexpr void write_chr(std::uint16_t addr, std::uint8_t value) const {
         assert(addr < 0x2000);
         cartridge_->chr_write(addr, value);
@@ -267,22 +322,24 @@ private:
         return static_cast<std::uint16_t>((0x3c0 + tile_y / 4 * 8 + tile_x / 4) | nametable_index);
     }
 
-    [[nodiscard]] constexpr auto read_tile_pixel(auto ix, auto tile, auto x, auto y) const {
-        const auto tile_offset = ix * 0x1000 + tile * 0x10;
-        const auto tile_lsb = read_chr(static_cast<std::uint16_t>(tile_offset + y + 0));
-        const auto tile_msb = read_chr(static_cast<std::uint16_t>(tile_offset + y + 8));
-        const auto pixel_lo = (tile_lsb >> (7 - x)) & 0x01;
-        const auto pixel_hi = (tile_msb >> (7 - x)) & 0x01;
-        return static_cast<std::uint8_t>(pixel_lo | (pixel_hi << 1));
+    // Row y of a tile in pattern table ix, its pixels decoded by the cartridge
+    [[nodiscard]] constexpr auto read_tile_row(auto ix, auto tile, auto y) const {
+        return read_chr_row(static_cast<std::uint16_t>(ix * 0x1000 + tile * 0x10 + y));
     }
 
-    [[nodiscard]] constexpr auto read_tile_pixel16(auto tile, auto x, auto y) const {
-        const auto tile_offset = (tile & 0x1) * 0x1000 + ((tile & 0xFE) + y / 8) * 0x10;
-        const auto tile_lsb = read_chr(static_cast<std::uint16_t>(tile_offset + y % 8 + 0));
-        const auto tile_msb = read_chr(static_cast<std::uint16_t>(tile_offset + y % 8 + 8));
-        const auto pixel_lo = (tile_lsb >> (7 - x)) & 0x01;
-        const auto pixel_hi = (tile_msb >> (7 - x)) & 0x01;
-        return static_cast<std::uint8_t>(pixel_lo | (pixel_hi << 1));
+    // Row y of an 8x16 sprite: tiles pair up in the table bit 0 picks
+    [[nodiscard]] constexpr auto read_tile_row16(auto tile, auto y) const {
+        return read_chr_row(static_cast<std::uint16_t>((tile & 0x1) * 0x1000 + ((tile & 0xFE) + y / 8) * 0x10 + y % 8));
+    }
+
+    [[nodiscard]] constexpr auto read_sprite_row(const auto& s, auto y) const {
+        return control.sprite_size() == sprite_size::sprite8x8
+            ? read_tile_row(control.pattern_table_fg_index(), s.tile, y)
+            : read_tile_row16(s.tile, y);
+    }
+
+    [[nodiscard]] constexpr auto read_tile_pixel(auto ix, auto tile, auto x, auto y) const {
+        return read_tile_row(ix, tile, y)[x];
     }
 
     [[nodiscard]] constexpr static auto read_tile_index(const auto& name_table, auto tile_x, auto tile_y, auto nametable_index) -> std::uint8_t {
@@ -329,24 +386,9 @@ private:
 
             screen.draw_pixel({x, y}, background_shown ? palette_table_.color_of(pixel, palette) : palette_table_.color_of(0, 0));
 
-            // Sprite 0 hit (requires both background and sprites enabled).
-            // OAM Y is the sprite's top row minus 1 on real hardware, hence + 1.
-            if (background_shown and show_sprites()) {
-                auto s = oam_.sprites[0];
-                auto height = control.sprite_size() == sprite_size::sprite8x8 ? 8 : 16;
-                if (x >= s.x and x < s.x + 8 and y >= s.y + 1 and y < s.y + 1 + height /* and pixel != 0*/) {
-                    auto dx = x - s.x;
-                    auto dy = y - (s.y + 1);
-                    auto j = (s.attr & 0x40) ? 7 - dx : dx;
-                    auto i = (s.attr & 0x80) ? height - 1 - dy : dy;
-                    auto sprite_pixel = control.sprite_size() == sprite_size::sprite8x8
-                        ? read_tile_pixel(control.pattern_table_fg_index(), s.tile, j, i)
-                        : read_tile_pixel16(s.tile, j, i);
-                    if (sprite_pixel != 0) {
-                        status |= 0x40;
-                    }
-                }
-            }
+            // Sprite 0 hit requires both background and sprites enabled
+            if (background_shown and show_sprites())
+                hit_sprite_zero(x, y);
         }
 
         // "At dot 257 of each scanline... horizontal bits are copied" -- the
@@ -359,6 +401,72 @@ private:
         }
     }
 
+    // Dots 2 to 257 of a visible line, as visible_scanline_old runs them
+    // with no register write in between: 33 tiles cover the 256 pixels,
+    // the first and the last only partly unless fine X is 0
+    template <screen screen_t>
+    constexpr void visible_scanline_whole(screen_t& screen) {
+        auto y = scan_.line();
+        auto [nametable_index_y, tile_y] = tile_y_scrolled(y);
+
+        auto tile_row = (y + active_scroll_y()) % 8;
+        auto fine_x = active_scroll_x() % 8;
+        auto backdrop = palette_table_.color_of(0, 0);
+
+        for (auto tile = 0; tile < 33 and show_background(); ++tile) {
+            auto left = static_cast<short>(tile * 8 - fine_x);
+            auto [nametable_index_x, tile_x] = tile_x_scrolled(left);
+
+            auto nametable_addr = nametable_address(nametable_index_x, nametable_index_y);
+
+            auto tile_index = read_tile_index(name_table_, tile_x, tile_y, nametable_addr);
+            auto palette = read_tile_palette(name_table_, tile_x, tile_y, nametable_addr);
+
+            auto colors = palette_table_.colors_of(read_tile_row(control.pattern_table_bg_index(), tile_index, tile_row), palette);
+
+            for (auto col = 0; col < 8; ++col) {
+                auto x = static_cast<short>(left + col);
+                if (x < 0 or x >= 256)
+                    continue;
+
+                auto background_shown = x >= 8 or show_background_leftmost();
+
+                screen.draw_pixel({x, y}, background_shown ? colors[col] : backdrop);
+            }
+        }
+
+        if (not show_background()) {
+            for (auto x = short{0}; x < 256; ++x)
+                screen.draw_pixel({x, y}, backdrop);
+        }
+
+        if (show_background() and show_sprites()) {
+            auto first = std::max(int{oam_.sprites[0].x}, show_background_leftmost() ? 0 : 8);
+            for (auto x = first; x < oam_.sprites[0].x + 8 and x < 256; ++x)
+                hit_sprite_zero(static_cast<short>(x), y);
+        }
+
+        if (rendering_enabled())
+            latch_render_scroll_x();
+
+        scan_.advance(256);
+    }
+
+    // OAM Y is the sprite's top row minus 1 on real hardware, hence + 1
+    constexpr void hit_sprite_zero(short x, short y) {
+        auto s = oam_.sprites[0];
+        auto height = control.sprite_size() == sprite_size::sprite8x8 ? 8 : 16;
+        if (x >= s.x and x < s.x + 8 and y >= s.y + 1 and y < s.y + 1 + height /* and pixel != 0*/) {
+            auto dx = x - s.x;
+            auto dy = y - (s.y + 1);
+            auto j = (s.attr & 0x40) ? 7 - dx : dx;
+            auto i = (s.attr & 0x80) ? height - 1 - dy : dy;
+            if (read_sprite_row(s, i)[j] != 0) {
+                status |= 0x40;
+            }
+        }
+    }
+
     template <screen screen_t>
     constexpr void visible_scanline(screen_t& screen);
 
@@ -372,10 +480,10 @@ private:
                 auto palette = static_cast<std::uint8_t>((s.attr & 0x03) + 4);
 
                 for (auto i = 0; i < (control.sprite_size() == sprite_size::sprite8x8 ? 8 : 16); ++i) {
+                    auto pixels = read_sprite_row(s, i);
+                    auto colors = palette_table_.colors_of(pixels, palette);
                     for (auto j = 0; j < 8; ++j) {
-                        auto pixel = control.sprite_size() == sprite_size::sprite8x8
-                            ? read_tile_pixel(control.pattern_table_fg_index(), s.tile, j, i)
-                            : read_tile_pixel16(s.tile, j, i);
+                        auto pixel = pixels[j];
                         auto dx = (s.attr & 0x40) ? 7 - j : j;// flipped horizontally
                         auto dy = (s.attr & 0x80)             // flipped vertically
                             ? (control.sprite_size() == sprite_size::sprite8x8 ? 7 : 15) - i
@@ -386,7 +494,7 @@ private:
                             // as the sprite-0 hit check
                             screen.draw_pixel(
                                 {screen_x, static_cast<short>(s.y + 1 + dy)},
-                                palette_table_.color_of(pixel, palette)
+                                colors[j]
                             );
                         }
                     }
@@ -402,10 +510,15 @@ private:
         // not dot 0.
         if (scan_.line() == VISIBLE_SCANLINES + POST_RENDER_SCANLINES and scan_.cycle() == 1) {
             status |= 0x80;
-            nmi_raised = control.raise_vblank_nmi();
+            if (control.raise_vblank_nmi())
+                raise_nmi();
         }
     };
 
+    [[nodiscard]] constexpr auto background_pattern_address() const noexcept {
+        return static_cast<std::uint16_t>(control.pattern_table_bg_index() * 0x1000 + background_.tile * 0x10 + scroll_.current.fine_y());
+    }
+
     [[nodiscard]] constexpr auto mirroring() const -> std::optional<name_table_mirroring> {
         if (cartridge_)
             return cartridge_->mirroring();
@@ -421,6 +534,44 @@ private:
     [[nodiscard]] constexpr auto show_sprites_leftmost() const noexcept -> bool { return (mask & 0x04) != 0; }
 
 private:
+    // What tick() fetches for the tile after next, and the shifters the
+    // pixels of the next two come out of, the current one in the high bytes
+    struct background_pipeline {
+        std::uint8_t tile{0};
+        std::uint8_t attribute{0};
+        std::uint8_t pattern_lo{0};
+        std::uint8_t pattern_hi{0};
+
+        std::uint16_t pattern_lo_shifter{0};
+        std::uint16_t pattern_hi_shifter{0};
+        std::uint16_t attribute_lo_shifter{0};
+        std::uint16_t attribute_hi_shifter{0};
+
+        constexpr void reload() noexcept {
+            pattern_lo_shifter = static_cast<std::uint16_t>((pattern_lo_shifter & 0xFF00) | pattern_lo);
+            pattern_hi_shifter = static_cast<std::uint16_t>((pattern_hi_shifter & 0xFF00) | pattern_hi);
+            attribute_lo_shifter = static_cast<std::uint16_t>((attribute_lo_shifter & 0xFF00) | ((attribute & 0x01) ? 0xFF : 0x00));
+            attribute_hi_shifter = static_cast<std::uint16_t>((attribute_hi_shifter & 0xFF00) | ((attribute & 0x02) ? 0xFF : 0x00));
+        }
+
+        constexpr void shift() noexcept {
+            pattern_lo_shifter = static_cast<std::uint16_t>(pattern_lo_shifter << 1);
+            pattern_hi_shifter = static_cast<std::uint16_t>(pattern_hi_shifter << 1);
+            attribute_lo_shifter = static_cast<std::uint16_t>(attribute_lo_shifter << 1);
+            attribute_hi_shifter = static_cast<std::uint16_t>(attribute_hi_shifter << 1);
+        }
+
+        // The pixel and its palette, fine X pixels into the current tile
+        [[nodiscard]] constexpr auto pixel(std::uint8_t fine_x) const noexcept {
+            auto bit = 15 - fine_x;
+            return std::pair{
+                static_cast<std::uint8_t>(((pattern_lo_shifter >> bit) & 0x01) | (((pattern_hi_shifter >> bit) & 0x01) << 1)),
+                static_cast<std::uint8_t>(((attribute_lo_shifter >> bit) & 0x01) | (((attribute_hi_shifter >> bit) & 0x01) << 1))};
+        }
+    };
+
+    background_pipeline background_;
+
     // The old renderer's latched scroll view -- see active_scroll_x/y
     int render_scroll_x_{0};
     int render_scroll_y_{0};
@@ -429,16 +580,25 @@ private:
 
     crt_scan scan_{SCANLINE_DOTS, VISIBLE_SCANLINES, POST_RENDER_SCANLINES, VERTICAL_BLANK_SCANLINES};
 
-    nes::name_table name_table_{[this]() constexpr { return mirroring(); }};
+    struct cartridge_mirroring {
+        const basic_ppu* ppu;
+        [[nodiscard]] constexpr auto operator()() const { return ppu->mirroring(); }
+    };
+
+    basic_name_table<cartridge_mirroring> name_table_{cartridge_mirroring{this}};
     nes::palette_table palette_table_;
     nes::object_attribute_memory oam_;
 
-    cartridge* cartridge_{nullptr};
+    cartridge_t* cartridge_{nullptr};
+    interrupt_lines* interrupts_{nullptr};
     std::uint8_t data_read_buffer_;
 };
 
+using ppu = basic_ppu<>;
+
+template <class cartridge_t>
 template <screen screen_t>
-constexpr void ppu::tick_old(screen_t& screen) {
+constexpr void basic_ppu<cartridge_t>::tick_old(screen_t& screen) {
     if (scan_.is_prerender()) {
         prerender_scanline_old();
     } else if (scan_.is_visible()) {
@@ -452,8 +612,21 @@ constexpr void ppu::tick_old(screen_t& screen) {
     scan_.advance();
 }
 
+template <class cartridge_t>
+template <screen screen_t>
+constexpr auto basic_ppu<cartridge_t>::run_old(screen_t& screen, std::uint64_t dots) -> int {
+    if (scan_.is_visible() and scan_.cycle() == 2 and dots >= 256) {
+        visible_scanline_whole(screen);
+        return 256;
+    }
+
+    tick_old(screen);
+    return 1;
+}
+
+template <class cartridge_t>
 template <screen screen_t>
-constexpr void ppu::tick(screen_t& screen) {
+constexpr void basic_ppu<cartridge_t>::tick(screen_t& screen) {
     if (scan_.is_prerender()) {
         prerender_scanline();
     }
@@ -468,20 +641,18 @@ constexpr void ppu::tick(screen_t& screen) {
     scan_.advance();
 }
 
-inline auto ppu::display_pattern_table(auto i, auto palette) const -> std::array<color, 128 * 128> {
+template <class cartridge_t>
+auto basic_ppu<cartridge_t>::display_pattern_table(auto i, auto palette) const -> std::array<color, 128 * 128> {
     auto result = std::array<color, 128 * 128>{};
 
     for (std::uint16_t tile_y = 0; tile_y < 16; ++tile_y) {
         for (std::uint16_t tile_x = 0; tile_x < 16; ++tile_x) {
             auto offset = static_cast<std::uint16_t>(tile_y * 16 + tile_x);
             for (std::uint16_t row = 0; row < 8; ++row) {
+                auto colors = palette_table_.colors_of(read_tile_row(i, offset, row), palette);
                 for (std::uint16_t col = 0; col < 8; col++) {
-                    auto pixel = read_tile_pixel(i, offset, col, row);
-
                     auto result_offset = (tile_y * 8 + row) * 128 + tile_x * 8 + (7 - col);
-                    auto result_color = palette_table_.color_of(pixel, palette);
-
-                    result[result_offset] = result_color;
+                    result[result_offset] = colors[col];
                 }
             }
         }
@@ -489,15 +660,14 @@ inline auto ppu::display_pattern_table(auto i, auto palette) const -> std::array
     return result;
 }
 
-constexpr void ppu::prerender_scanline_old() noexcept {
+template <class cartridge_t>
+constexpr void basic_ppu<cartridge_t>::prerender_scanline_old() noexcept {
     // Real hardware clears vblank/sprite-0/overflow at dot 1 of the
     // pre-render line, not dot 0 -- matches the dot-1 set in
     // vertical_blank_line_old, so the flag's held duration is unchanged.
     if (scan_.cycle() == 1) {
         status = 0x00;
         control.smb_hotfix();
-        nmi_raised = false;
-        nmi_seen = false;
     }
     // The pre-render line runs the same dot-257 horizontal copy every
     // rendering line does -- this is what makes scanline 0 of the next
@@ -513,59 +683,91 @@ constexpr void ppu::prerender_scanline_old() noexcept {
     }
 }
 
-constexpr void ppu::prerender_scanline() noexcept {
+template <class cartridge_t>
+constexpr void basic_ppu<cartridge_t>::prerender_scanline() noexcept {
     if (scan_.cycle() == 1) {
         status = 0x00;
     }
 }
 
+// The background as hardware draws it: every 8 dots the next tile's
+// nametable entry, attribute and pattern bytes are fetched through v, then
+// go into the low bytes of the shifters, which shift one pixel out each
+// dot. Pixel x comes out of them at dot x + 1 and is drawn at dot x + 2,
+// the first two tiles of a line having been fetched at the end of the
+// line before
+template <class cartridge_t>
 template <screen screen_t>
-constexpr void ppu::visible_scanline(screen_t& screen) {
-    if (scan_.cycle() >= 2 and scan_.cycle() <= 257) {
-        // draw pixel
-    }
-    if ((scan_.cycle() >= 2 and scan_.cycle() <= 255) or (scan_.cycle() >= 322 and scan_.cycle() <= 337)) {
-        // update registers
-        switch (scan_.cycle() % 8) {
-            case 1:
-                // NT
-                break;
-            case 2:
-                // NT
-                break;
-            case 3:
-                // AT
-                break;
-            case 4:
-                // AT
-                break;
-            case 5:
-                // BG lsbits
-                break;
-            case 6:
-                // BG lsbits
-                break;
-            case 7:
-                // BG msbits
-                break;
-            case 0:
-                // BG msbits
-                // inc horiz v
-                break;
-        }
-    }
-    if (scan_.cycle() == 1 or scan_.cycle() == 321 or scan_.cycle() == 339) {
+constexpr void basic_ppu<cartridge_t>::visible_scanline(screen_t& screen) {
+    auto cycle = scan_.cycle();
+
+    // The pixel the shifters hold since the dot before, drawn on the dot
+    // visible_scanline_old draws it, so register writes land between the
+    // same two pixels
+    if (scan_.is_visible() and cycle >= 2 and cycle <= 257) {
+        auto x = static_cast<short>(cycle - 2);
+        auto y = scan_.line();
+
+        auto background_shown = show_background() and (x >= 8 or show_background_leftmost());
+        auto [pixel, palette] = background_shown ? background_.pixel(scroll_.fine_x) : std::pair<std::uint8_t, std::uint8_t>{};
+
+        screen.draw_pixel({x, y}, palette_table_.color_of(pixel, palette));
+
+        if (background_shown and show_sprites())
+            hit_sprite_zero(x, y);
     }
-    if (scan_.cycle() == 338 or scan_.cycle() == 340) {
+
+    if (rendering_enabled()) {
+        if ((cycle >= 2 and cycle <= 257) or (cycle >= 322 and cycle <= 337))
+            background_.shift();
+
+        if ((cycle >= 1 and cycle <= 256) or (cycle >= 321 and cycle <= 336)) {
+            switch (cycle % 8) {
+                case 1:
+                    background_.reload();
+                    background_.tile = name_table_.read(scroll_.current.tile_address() & 0x0FFF);
+                    break;
+                case 3: {
+                    auto attr_byte = name_table_.read(scroll_.current.attribute_address() & 0x0FFF);
+                    background_.attribute = tile_palette(scroll_.current.coarse_x(), scroll_.current.coarse_y(), attr_byte);
+                    break;
+                }
+                case 5:
+                    background_.pattern_lo = read_chr(background_pattern_address());
+                    break;
+                case 7:
+                    background_.pattern_hi = read_chr(static_cast<std::uint16_t>(background_pattern_address() + 8));
+                    break;
+                case 0:
+                    scroll_.current.step_tile_right();
+                    break;
+            }
+        }
+
+        if (cycle == 256)
+            scroll_.current.step_pixel_down();
+
+        if (cycle == 257) {
+            background_.reload();
+            scroll_.current.reload_column_from(scroll_.staged);
+        }
+
+        if (scan_.is_prerender() and cycle >= 280 and cycle <= 304)
+            scroll_.current.reload_row_from(scroll_.staged);
     }
+
 }
 
+// Sprites are still drawn all at once, over the finished background
+template <class cartridge_t>
 template <screen screen_t>
-constexpr void ppu::postrender_scanline(screen_t& screen) {
+constexpr void basic_ppu<cartridge_t>::postrender_scanline(screen_t& screen) {
+    postrender_scanline_old(screen);
 }
 
+template <class cartridge_t>
 template <screen screen_t>
-void ppu::render_nametables(screen_t& screen) {
+void basic_ppu<cartridge_t>::render_nametables(screen_t& screen) {
     for (auto y: std::views::iota(short{0}, short{256 * 2})) {
         for (auto x: std::views::iota(short{0}, short{256 * 2})) {
             const auto y_of_tile = (y % 256) / 8;
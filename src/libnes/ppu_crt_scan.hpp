@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cassert>
+
 namespace nes
 {
 
@@ -17,6 +19,17 @@ public:
     [[nodiscard]] constexpr auto is_odd_frame() const noexcept { return frame_is_odd_; }
     [[nodiscard]] constexpr auto is_frame_finished() const noexcept { return line_ == -1 and cycle_ == 0; }
 
+    [[nodiscard]] constexpr auto frame_dots() const noexcept {
+        return dots_ * (1 + visible_scanlines_ + postrender_scanlines_ + vblank_scanlines_);
+    }
+
+    // Dots to advance before the scan is at `line`/`cycle`, wrapping into
+    // the next frame if that position is already behind
+    [[nodiscard]] constexpr auto dots_until(int line, int cycle) const noexcept {
+        auto position = [this](int l, int c) { return (l + 1) * dots_ + c; };
+        return (position(line, cycle) - position(line_, cycle_) + frame_dots()) % frame_dots();
+    }
+
     [[nodiscard]] constexpr auto is_prerender() const noexcept {
         return line_ == -1;
     }
@@ -34,6 +47,12 @@ public:
             line_ < visible_scanlines_ + postrender_scanlines_ + vblank_scanlines_;
     }
 
+    // Several dots at once, within the line
+    constexpr void advance(int dots) noexcept {
+        assert(cycle_ + dots < dots_);
+        cycle_ = static_cast<short>(cycle_ + dots);
+    }
+
     constexpr void advance() noexcept {
         if (++cycle_ >= dots_) {
             cycle_ = 0;
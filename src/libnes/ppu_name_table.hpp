@@ -21,11 +21,14 @@ enum class name_table_mirroring {
     horizontal,
 };
 
-class name_table
+// The mirroring source is consulted on every access; a concrete callback type
+// lets it inline, std::function keeps name_table usable on its own
+template <class mirroring_callback_t = std::function<std::optional<name_table_mirroring>()>>
+class basic_name_table
 {
 public:
-    using mirroring_callback = std::function<std::optional<name_table_mirroring>()>;
-    explicit name_table(mirroring_callback mirroring)
+    using mirroring_callback = mirroring_callback_t;
+    explicit basic_name_table(mirroring_callback mirroring)
         : mirroring_{std::move(mirroring)} {}
 
     void write(std::uint16_t addr, std::uint8_t value) {
@@ -71,4 +74,6 @@ private:
     mirroring_callback mirroring_;
 };
 
+using name_table = basic_name_table<>;
+
 }// namespace nes
\ No newline at end of file
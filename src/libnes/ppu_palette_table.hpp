@@ -4,6 +4,7 @@
 
 #include <array>
 #include <cstdint>
+#include <span>
 
 namespace nes
 {
@@ -14,6 +15,7 @@ public:
     explicit constexpr palette_table(const auto& system_color_palette)
         : system_colors_{system_color_palette} {
         palette_ram_.fill(0);
+        resolve_all();
     }
 
     [[nodiscard]] static constexpr auto palette_address(std::uint8_t address) noexcept {
@@ -31,17 +33,71 @@ public:
     }
 
     constexpr void write(std::uint8_t address, std::uint8_t value) noexcept {
-        palette_ram_[palette_address(address)] = value;
+        address = palette_address(address);
+        palette_ram_[address] = value;
+
+        // and the entry that mirrors it, if any: $3F10 for $3F00 and so on
+        resolve(address);
+        if ((address & 0x03) == 0)
+            resolve(address | 0x10);
+    }
+
+    // The greyscale and emphasis bits of $2001 PPUMASK, which apply to
+    // every color the PPU outputs
+    constexpr void set_mask(std::uint8_t mask) noexcept {
+        mask &= 0xE1;
+        if (mask == mask_)
+            return;
+
+        mask_ = mask;
+        resolve_all();
     }
 
-    [[nodiscard]] auto color_of(std::uint8_t pixel, std::uint8_t palette) const noexcept -> color {
-        auto rpc = pixel ? read((palette << 2) + pixel) : read(0x00);
-        return system_colors_[rpc & 0x3F];
+    [[nodiscard]] constexpr auto color_of(std::uint8_t pixel, std::uint8_t palette) const noexcept -> color {
+        return resolved_[pixel ? ((palette << 2) | pixel) & 0x1F : 0];
+    }
+
+    // The colors of a row of pixels of one palette: its four colors are
+    // looked up once, and each pixel picks one
+    [[nodiscard]] auto colors_of(std::span<const std::uint8_t, 8> pixels, std::uint8_t palette) const noexcept -> std::array<color, 8> {
+        const auto colors = std::array{color_of(0, palette), color_of(1, palette), color_of(2, palette), color_of(3, palette)};
+
+        auto result = std::array<color, 8>{};
+        for (auto i = 0; i < 8; ++i)
+            result[i] = colors[pixels[i] & 0x03];
+        return result;
     }
 
 private:
+    constexpr void resolve_all() noexcept {
+        for (auto address = 0; address < 32; ++address)
+            resolve(static_cast<std::uint8_t>(address));
+    }
+
+    // The color a palette entry shows: greyscale keeps only the entry's
+    // brightness column, and each emphasis bit (red, green, blue from bit
+    // 5 up) dims the channels other than its own
+    constexpr void resolve(std::uint8_t address) noexcept {
+        auto index = read(address) & ((mask_ & 0x01) ? 0x30 : 0x3F);
+        auto value = system_colors_[index].value();
+
+        auto emphasis = mask_ >> 5;
+        if (emphasis != 0) {
+            auto channel = [&](int bit, int shift) {
+                auto c = (value >> shift) & 0xFF;
+                return static_cast<std::uint8_t>((emphasis & ~bit) != 0 ? c * 3 / 4 : c);
+            };
+            value = color{channel(0b001, 16), channel(0b010, 8), channel(0b100, 0), static_cast<std::uint8_t>(value >> 24)}.value();
+        }
+
+        resolved_[address] = color{value};
+    }
+
     std::array<std::uint8_t, 32> palette_ram_{};
     const std::array<color, 64>& system_colors_;
+
+    std::uint8_t mask_{0};
+    std::array<color, 32> resolved_{};// what each entry shows, mirrors included
 };
 
 }
\ No newline at end of file
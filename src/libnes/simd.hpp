@@ -0,0 +1,16 @@
+#pragma once
+
+// SSE2 is part of x86-64, so any 64-bit x86 build can use it without
+// flags or a check at run time. Everywhere else the plain loops run, as
+// they do in a build that defines LIBNES_SSE2 as 0
+#ifndef LIBNES_SSE2
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define LIBNES_SSE2 1
+#else
+#define LIBNES_SSE2 0
+#endif
+#endif
+
+#if LIBNES_SSE2
+#include <emmintrin.h>
+#endif
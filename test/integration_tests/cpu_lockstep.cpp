@@ -0,0 +1,182 @@
+#include <catch2/catch_all.hpp>
+#include <cstring>
+#include <format>
+#include <random>
+#include <vector>
+
+#include <libnes/cpu.hpp>
+#include <libnes/cpu_disassembler.hpp>
+#include <libnes/cpu_opcodes.hpp>
+#include <libnes/literals.hpp>
+
+using namespace nes::literals;
+
+namespace
+{
+
+struct memory_write {
+    std::uint16_t addr;
+    std::uint8_t value;
+
+    auto operator==(const memory_write&) const -> bool = default;
+};
+
+// Plain memory, the upper half read-only like a cartridge's, that keeps a
+// log of the writes made to it
+struct logging_bus {
+    void write(std::uint16_t addr, std::uint8_t value) {
+        writes.push_back({addr, value});
+        if (addr < 0x8000)
+            mem[addr] = value;
+    }
+
+    [[nodiscard]] std::uint8_t read(std::uint16_t addr) const { return mem[addr]; }
+    [[nodiscard]] bool nmi() const { return false; }
+
+    std::vector<std::uint8_t> mem;
+    std::vector<memory_write> writes;
+};
+
+// The same, with its read-only half handed to the CPU as code to predecode
+struct logging_code_bus: logging_bus {
+    [[nodiscard]] auto code_page(std::uint8_t page) const -> const std::uint8_t* {
+        return page >= 0x80 ? mem.data() + page * 0x100 : nullptr;
+    }
+};
+
+// Random code: every byte of memory, operands and data included, is an
+// opcode the CPU implements, so wherever the program jumps, and whatever
+// it reads as an operand, it only traps on what it wrote itself. The
+// vectors all point into the read-only half
+auto random_program(std::uint32_t seed) -> std::vector<std::uint8_t> {
+    auto implemented = std::vector<std::uint8_t>{};
+    for (auto opcode = 0; opcode < 0x100; ++opcode) {
+        if (nes::OPCODES[opcode].mnemonic != nes::mnemonic::unsupported)
+            implemented.push_back(static_cast<std::uint8_t>(opcode));
+    }
+
+    auto random = std::mt19937{seed};
+    auto pick = std::uniform_int_distribution<std::size_t>{0, implemented.size() - 1};
+
+    auto memory = std::vector<std::uint8_t>(64_Kb);
+    for (auto& byte: memory)
+        byte = implemented[pick(random)];
+
+    for (auto vector = 0xFFFA; vector < 0x10000; vector += 2)
+        memory[vector + 1] |= 0x80;
+
+    return memory;
+}
+
+template <class bus_t>
+auto make_bus(const std::vector<std::uint8_t>& memory) {
+    auto bus = bus_t{};
+    bus.mem = memory;
+    return bus;
+}
+
+// The instruction at PC, as nestest.log would have it
+template <class cpu_t>
+auto trace(const cpu_t& cpu, const logging_bus& bus) -> std::string {
+    auto at = cpu.pc.value();
+    auto bytes = std::array{
+        bus.mem[at],
+        bus.mem[static_cast<std::uint16_t>(at + 1)],
+        bus.mem[static_cast<std::uint16_t>(at + 2)]};
+
+    return nes::trace_line(cpu.save_state(), bytes);
+}
+
+// Runs two CPUs, each on its own copy of the same memory, one instruction
+// at a time, and checks that after each they have the same registers, took
+// the same cycles and wrote the same values at the same addresses in the
+// same order. A program that runs into an opcode the CPU doesn't implement
+// ends there, on both. How each runs its instruction is up to the caller
+template <class reference_bus_t, class candidate_bus_t>
+class lockstep
+{
+public:
+    explicit lockstep(const std::vector<std::uint8_t>& memory)
+        : reference_bus_{make_bus<reference_bus_t>(memory)}
+        , candidate_bus_{make_bus<candidate_bus_t>(memory)}
+        , reference_{reference_bus_}
+        , candidate_{candidate_bus_} {}
+
+    void run(int instructions, auto run_reference, auto run_candidate) {
+        for (auto i = 0; i < instructions; ++i) {
+            reference_bus_.writes.clear();
+            candidate_bus_.writes.clear();
+
+            auto before = trace(reference_, reference_bus_);
+            auto reference_cycles = 0;
+            try {
+                reference_cycles = run_reference(reference_);
+            }
+            catch (const nes::unsupported_opcode&) {
+                INFO(std::format("instruction {}: {}", i, before));
+                CHECK_THROWS_AS(run_candidate(candidate_), nes::unsupported_opcode);
+                break;
+            }
+            auto candidate_cycles = run_candidate(candidate_);
+
+            auto reference_state = reference_.save_state();
+            auto candidate_state = candidate_.save_state();
+            auto same = std::memcmp(&reference_state, &candidate_state, sizeof(reference_state)) == 0
+                and reference_cycles == candidate_cycles
+                and reference_bus_.writes == candidate_bus_.writes;
+
+            if (not same) {
+                INFO(std::format("instruction {}: {}", i, before));
+                INFO(std::format("reference  {} in {} cycles, {} writes", trace(reference_, reference_bus_), reference_cycles, reference_bus_.writes.size()));
+                INFO(std::format("candidate  {} in {} cycles, {} writes", trace(candidate_, candidate_bus_), candidate_cycles, candidate_bus_.writes.size()));
+                FAIL("the CPUs diverged");
+            }
+        }
+
+        CHECK(reference_bus_.mem == candidate_bus_.mem);
+    }
+
+    [[nodiscard]] auto candidate() -> nes::cpu<candidate_bus_t>& { return candidate_; }
+
+private:
+    reference_bus_t reference_bus_;
+    candidate_bus_t candidate_bus_;
+
+    nes::cpu<reference_bus_t> reference_;
+    nes::cpu<candidate_bus_t> candidate_;
+};
+
+// The interpreter at its plainest: one cycle at a time
+auto tick_instruction = [](auto& cpu) {
+    auto cycles = 0;
+    do {
+        cpu.tick();
+        ++cycles;
+    } while (cpu.is_executing());
+    return cycles;
+};
+
+auto step_instruction = [](auto& cpu) { return cpu.step(); };
+
+constexpr auto SEEDS = 16;
+constexpr auto INSTRUCTIONS = 20000;
+
+}// namespace
+
+TEST_CASE("Lockstep - whole instructions against cycle by cycle") {
+    for (auto seed = 0u; seed < SEEDS; ++seed) {
+        INFO(std::format("seed {}", seed));
+
+        auto harness = lockstep<logging_bus, logging_bus>{random_program(seed)};
+        harness.run(INSTRUCTIONS, tick_instruction, step_instruction);
+    }
+}
+
+TEST_CASE("Lockstep - predecoded code against cycle by cycle") {
+    for (auto seed = 0u; seed < SEEDS; ++seed) {
+        INFO(std::format("seed {}", seed));
+
+        auto harness = lockstep<logging_bus, logging_code_bus>{random_program(seed)};
+        harness.run(INSTRUCTIONS, tick_instruction, step_instruction);
+    }
+}
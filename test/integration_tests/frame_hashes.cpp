@@ -0,0 +1,101 @@
+#include <catch2/catch_all.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <libnes/console.hpp>
+
+#include "load_rom.hpp"
+
+namespace
+{
+
+// Keeps the frame and hashes it: FNV-1a over the pixels' colors
+struct hashing_screen {
+    [[nodiscard]] constexpr static auto width() -> short { return 256; }
+    [[nodiscard]] constexpr static auto height() -> short { return 240; }
+
+    void draw_pixel(nes::point p, nes::color c) {
+        if (p.x >= 0 and p.x < 256 and p.y >= 0 and p.y < 240)
+            pixels[static_cast<std::size_t>(p.y * 256 + p.x)] = c.value();
+    }
+
+    [[nodiscard]] auto hash() const -> std::uint64_t {
+        auto h = std::uint64_t{1469598103934665603u};
+        for (auto pixel: pixels) {
+            h ^= pixel;
+            h *= 1099511628211u;
+        }
+        return h;
+    }
+
+    std::vector<std::uint32_t> pixels = std::vector<std::uint32_t>(256 * 240);
+};
+
+struct rom_frames {
+    std::string filename;
+    std::uint64_t hash;// of its first FRAMES frames, with no input
+};
+
+constexpr auto FRAMES = 120;
+
+// Every frame's hash, folded into one, with the keys held throughout
+auto render(nes::console& console, std::uint8_t keys = 0) -> std::uint64_t {
+    auto screen = hashing_screen{};
+    auto hash = std::uint64_t{0};
+
+    for (auto frame = 0; frame < FRAMES; ++frame) {
+        console.controller_input(keys);
+        console.render_frame(screen);
+        hash = hash * 31 + screen.hash();
+    }
+
+    return hash;
+}
+
+}// namespace
+
+// The frames the ROMs in rom/ render, as the dot-by-dot renderer drew them
+// when these were recorded. Any renderer has to keep them pixel for pixel
+TEST_CASE("Frame hashes") {
+    auto rom = GENERATE(
+        rom_frames{"rom/firedemo.nes", 0xcef0006c0b9f6f38},
+        rom_frames{"rom/color_test.nes", 0x7b70cac8b644d380},
+        rom_frames{"rom/nestest.nes", 0xa9f7e7c29e5b61e4});
+
+    INFO(rom.filename);
+    auto console = nes::console{load_rom(rom.filename)};
+
+    SECTION("Whole lines where nothing interrupts them") {
+        CHECK(render(console) == rom.hash);
+    }
+    SECTION("The fetch pipeline, a dot at a time") {
+        console.pipelined_rendering(true);
+        CHECK(render(console) == rom.hash);
+    }
+    SECTION("Idle loops skipped") {
+        console.skip_idle_loops(true);
+        CHECK(render(console) == rom.hash);
+    }
+}
+
+// color_test turns on greyscale ($2001 = $1F) while A is held, so its red
+// entry has to show as the grey of its brightness column
+TEST_CASE("Frame hashes with greyscale on") {
+    constexpr auto A = std::uint8_t{0x80};
+    constexpr auto HASH = std::uint64_t{0xe1d69340e121718c};
+
+    auto console = nes::console{load_rom("rom/color_test.nes")};
+
+    SECTION("Whole lines where nothing interrupts them") {
+        CHECK(render(console, A) == HASH);
+    }
+    SECTION("The fetch pipeline, a dot at a time") {
+        console.pipelined_rendering(true);
+        CHECK(render(console, A) == HASH);
+    }
+    SECTION("Idle loops skipped") {
+        console.skip_idle_loops(true);
+        CHECK(render(console, A) == HASH);
+    }
+}
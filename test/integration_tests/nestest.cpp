@@ -1,9 +1,13 @@
 #include <catch2/catch_all.hpp>
 #include <chrono>
+#include <filesystem>
 #include <fstream>
 #include <ranges>
+#include <sstream>
 
 #include <libnes/cpu.hpp>
+#include <libnes/cpu_disassembler.hpp>
+#include <libnes/cpu_trace.hpp>
 #include <libnes/literals.hpp>
 
 using namespace nes::literals;
@@ -30,13 +34,14 @@ public:
         p.set(nes::cpu_flag::int_disable);
     }
 
-    std::ostream& print_status(std::ostream& stream) {
-        return stream << std::hex << std::setw(4) << std::setfill('0') << pc.value() << '\t'
-                      << "A:" << std::setw(2) << std::setfill('0') << (int) a.value() << ' '
-                      << "X:" << std::setw(2) << std::setfill('0') << (int) x.value() << ' '
-                      << "Y:" << std::setw(2) << std::setfill('0') << (int) y.value() << ' '
-                      << "P:" << std::setw(2) << std::setfill('0') << (int) p.value() << ' '
-                      << "SP:" << std::setw(2) << std::setfill('0') << (int) s.value();
+    std::ostream& print_status(std::ostream& stream, std::uint64_t cycle) {
+        auto at = pc.value();
+        auto bytes = std::array{
+            read(at),
+            read(static_cast<std::uint16_t>(at + 1)),
+            read(static_cast<std::uint16_t>(at + 2))};
+
+        return stream << nes::trace_line(save_state(), bytes) << std::format(" CYC:{}", cycle);
     }
 
     [[nodiscard]] auto is_test_finished() const { return pc.value() == 0x1983; }
@@ -66,20 +71,17 @@ TEST_CASE("The ultimate NES CPU test ROM (aka nestest)") {
     auto start_time = std::chrono::system_clock::now();
 
     auto instruction_count = 0;
-    auto cycle = 0;
+    auto cycle = std::uint64_t{0};
 
     try {
         log << std::format("nestest, test started: {:%F} {:%T}\n", start_time, std::chrono::floor<std::chrono::seconds>(start_time));
 
-        for (; !cpu.is_test_finished(); ++cycle) {
+        for (; !cpu.is_test_finished(); ++instruction_count) {
             if (cycle > 10000000)
                 throw std::runtime_error("Probably an infinite loop");
 
-            if (!cpu.is_executing()) {
-                cpu.print_status(log) << '\n';
-                ++instruction_count;
-            }
-            cpu.tick();
+            cpu.print_status(log, cycle) << '\n';
+            cycle += cpu.step();
         }
     } catch (const std::exception& ex) {
         FAIL_CHECK(ex.what());
@@ -89,4 +91,38 @@ TEST_CASE("The ultimate NES CPU test ROM (aka nestest)") {
 
     CHECK((int) m[0x02] == 0x00);
     CHECK((int) m[0x03] == 0x00);
-}
\ No newline at end of file
+}
+
+// The binary trace, written out as text, is the log the CPU prints as it
+// goes
+TEST_CASE("nestest, traced to a file") {
+    auto m = load_nestest();
+    auto bus = test_bus{m};
+    auto cpu = test_cpu{bus};
+
+    const auto filename = std::filesystem::temp_directory_path() / "nestest.trace";
+
+    auto expected = std::ostringstream{};
+    {
+        auto recorder = nes::trace_recorder{filename.string()};
+        cpu.trace(&recorder);
+
+        auto cycle = std::uint64_t{0};
+        while (not cpu.is_test_finished()) {
+            cpu.print_status(expected, cycle) << '\n';
+            cycle += static_cast<std::uint64_t>(cpu.step());
+        }
+
+        cpu.trace(nullptr);
+        CHECK(recorder.dropped() == 0);
+    }
+
+    auto log = std::ostringstream{};
+    {
+        auto trace = std::ifstream{filename, std::ifstream::binary};
+        nes::write_nestest_log(trace, log);
+    }
+    std::filesystem::remove(filename);
+
+    CHECK(log.str() == expected.str());
+}
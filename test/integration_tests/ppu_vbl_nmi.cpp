@@ -3,62 +3,12 @@
 #include <ranges>
 
 #include <libnes/console.hpp>
-#include <libnes/literals.hpp>
-#include <libnes/mappers/mmc1.hpp>
-#include <libnes/mappers/nrom.hpp>
 
-using namespace nes::literals;
+#include "load_rom.hpp"
 
 namespace
 {
 
-auto load_rom(const std::string& filename) -> std::unique_ptr<nes::cartridge> {
-    auto romfile = std::ifstream{filename, std::ifstream::binary};
-    REQUIRE(romfile.is_open());
-
-    nes::ines_header header{};
-    romfile.read(reinterpret_cast<char*>(&header), sizeof(header));
-
-    auto mapper_ix = (header.mapper1 >> 4) | (header.mapper2 & 0xF0);
-
-    if (mapper_ix == 0) {
-        auto prg = std::vector<std::array<std::uint8_t, 16_Kb>>{};
-        for (auto i = 0; i < header.prg_rom_chunks; ++i) {
-            prg.emplace_back();
-            romfile.read(reinterpret_cast<char*>(prg.back().data()), prg.back().size());
-        }
-
-        auto chr0 = nes::membank<4_Kb>{};
-        romfile.read(reinterpret_cast<char*>(chr0.data()), chr0.size());
-        auto chr1 = nes::membank<4_Kb>{};
-        romfile.read(reinterpret_cast<char*>(chr1.data()), chr1.size());
-
-        auto mirroring = (header.mapper1 & 0x01)
-            ? nes::name_table_mirroring::vertical
-            : nes::name_table_mirroring::horizontal;
-
-        return std::make_unique<nes::nrom>(prg, chr0, chr1, mirroring);
-    }
-
-    if (mapper_ix == 1) {
-        auto prg = std::vector<std::array<std::uint8_t, 16_Kb>>{};
-        for (auto i = 0; i < header.prg_rom_chunks; ++i) {
-            prg.emplace_back();
-            romfile.read(reinterpret_cast<char*>(prg.back().data()), prg.back().size());
-        }
-
-        auto chr = std::vector<nes::membank<4_Kb>>{};
-        for (auto i = 0; i < header.chr_rom_chunks * 2; ++i) {
-            chr.emplace_back();
-            romfile.read(reinterpret_cast<char*>(chr.back().data()), chr.back().size());
-        }
-
-        return std::make_unique<nes::mmc1>(prg, chr);
-    }
-
-    throw std::runtime_error("Unsupported mapper " + std::to_string(mapper_ix));
-}
-
 struct null_screen {
     [[nodiscard]] constexpr static auto width() -> short { return 256; }
     [[nodiscard]] constexpr static auto height() -> short { return 240; }
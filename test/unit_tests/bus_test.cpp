@@ -2,6 +2,12 @@
 
 #include <libnes/console.hpp>
 
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 using namespace nes::literals;
 
 struct bus_test {
@@ -18,14 +24,17 @@ struct bus_test {
         void load_cartridge(nes::cartridge* rom) noexcept { cartridge = rom; }
         void eject_cartridge() noexcept { load_cartridge(nullptr); }
         void nametable_mirroring(auto) noexcept {}
+        void connect(nes::interrupt_lines* lines) noexcept { interrupts = lines; }
 
         std::unordered_map<std::uint16_t, std::uint8_t> bytes_written;
         std::unordered_map<std::uint16_t, std::uint8_t> bytes_to_read;
         nes::cartridge* cartridge{nullptr};
+        nes::interrupt_lines* interrupts{nullptr};
     };
 
     struct test_cartridge: nes::cartridge {
         nes::membank<4_Kb> cart_chr{};
+        mutable std::array<std::uint8_t, 8> row{};
         nes::name_table_mirroring cart_mirroring{nes::name_table_mirroring::vertical};
         std::unordered_map<std::uint16_t, std::uint8_t> bytes_written;
 
@@ -33,6 +42,12 @@ struct bus_test {
             return cart_chr[addr % 4_Kb];
         }
 
+        // Decoded on every call, so that tests can poke cart_chr
+        [[nodiscard]] auto chr_row(std::uint16_t addr) const noexcept -> std::span<const std::uint8_t, 8> override {
+            row = nes::decode_tile_row(cart_chr[addr % 4_Kb], cart_chr[(addr + 8) % 4_Kb]);
+            return row;
+        }
+
         [[nodiscard]] auto mirroring() const noexcept -> nes::name_table_mirroring override {
             return cart_mirroring;
         }
@@ -121,4 +136,218 @@ TEST_CASE_METHOD(bus_test, "Bus - write data") {
         bus.write(0xC000, 0x67);
         CHECK(cartridge.bytes_written.at(0xC000) == 0x67);
     }
-}
\ No newline at end of file
+    SECTION("writes on consecutive cycles all reach the cartridge") {
+        // Which of them count is up to the board
+        bus.write(0xC000, 0x67);
+        bus.advance(1);
+        bus.write(0xC001, 0x68);
+
+        CHECK(cartridge.bytes_written.at(0xC000) == 0x67);
+        CHECK(cartridge.bytes_written.at(0xC001) == 0x68);
+    }
+}
+
+TEST_CASE_METHOD(bus_test, "Bus - catch up") {
+    auto caught_up = std::vector<std::uint64_t>{};
+    bus.catch_up = [&caught_up](auto cycle) { caught_up.push_back(cycle); };
+
+    bus.advance(7);
+    REQUIRE(bus.cycle() == 7);
+
+    SECTION("memory access doesn't catch the PPU up") {
+        bus.write(0x0011, 0x13);
+        [[maybe_unused]] auto _ = bus.read(0x0011);
+
+        CHECK(caught_up.empty());
+    }
+    SECTION("PPU register access catches the PPU up to the current cycle") {
+        bus.write(0x2005, 0x88);
+        bus.advance(3);
+        ppu.bytes_to_read[0x2002] = 0x80;
+        [[maybe_unused]] auto _ = bus.read(0x2002);
+
+        CHECK(caught_up == std::vector<std::uint64_t>{7, 10});
+    }
+    SECTION("OAM DMA catches the PPU up") {
+        bus.write(0x4014, 0x02);
+
+        CHECK(caught_up == std::vector<std::uint64_t>{7});
+    }
+    SECTION("cartridge writes catch the PPU up") {
+        bus.write(0x8000, 0x01);
+
+        CHECK(caught_up == std::vector<std::uint64_t>{7});
+    }
+    SECTION("Interrupt check catches up only once the NMI may have been raised") {
+        bus.nmi_cycle = 10;
+
+        CHECK_FALSE(bus.interrupts().pending(false));
+        CHECK(caught_up.empty());
+
+        bus.advance(3);
+        CHECK_FALSE(bus.interrupts().pending(false));
+        CHECK(caught_up == std::vector<std::uint64_t>{10});
+    }
+}
+
+TEST_CASE_METHOD(bus_test, "Bus - interrupts") {
+    struct irq_cartridge: test_cartridge {
+        void hold_irq(bool asserted) { irq(asserted); }
+    };
+
+    SECTION("the PPU raises the NMI") {
+        REQUIRE(ppu.interrupts == &bus.interrupts());
+
+        ppu.interrupts->raise_nmi();
+
+        CHECK(bus.interrupts().pending(true));
+        CHECK(bus.interrupts().acknowledge_nmi());
+        CHECK_FALSE(bus.interrupts().pending(false));
+    }
+    SECTION("the cartridge holds the IRQ until it lets go") {
+        auto irq_cart = irq_cartridge{};
+        bus.load_cartridge(&irq_cart);
+
+        irq_cart.hold_irq(true);
+        CHECK(bus.interrupts().pending(false));
+        CHECK_FALSE(bus.interrupts().pending(true));
+
+        irq_cart.hold_irq(false);
+        CHECK_FALSE(bus.interrupts().pending(false));
+    }
+    SECTION("ejecting the cartridge releases its IRQ") {
+        auto irq_cart = irq_cartridge{};
+        bus.load_cartridge(&irq_cart);
+        irq_cart.hold_irq(true);
+
+        bus.eject_cartridge();
+        CHECK_FALSE(bus.interrupts().irq());
+
+        irq_cart.hold_irq(true);
+        CHECK_FALSE(bus.interrupts().irq());
+    }
+}
+
+TEST_CASE_METHOD(bus_test, "Bus - memory map") {
+    struct banked_cartridge: test_cartridge {
+        std::array<nes::membank<256>, 2> prg{};
+        nes::membank<256> prg_ram{};
+        std::size_t bank{0};
+
+        auto write(std::uint16_t, std::uint8_t value) -> bool override {
+            bank = value & 0x01;
+            return true;
+        }
+
+        [[nodiscard]] auto read_page(std::uint8_t page) -> const std::uint8_t* override {
+            return page >= 0x80 ? prg[bank].data() : write_page(page);
+        }
+
+        [[nodiscard]] auto write_page(std::uint8_t page) -> std::uint8_t* override {
+            return page == 0x60 ? prg_ram.data() : nullptr;
+        }
+    } banked;
+
+    banked.prg[0][0x34] = 0x56;
+    banked.prg[1][0x34] = 0x78;
+    bus.load_cartridge(&banked);
+
+    SECTION("cartridge pages are read directly") {
+        CHECK(bus.read(0x8034) == 0x56);
+        CHECK(bus.read(0xFF34) == 0x56);
+    }
+    SECTION("cartridge RAM pages are written directly") {
+        bus.write(0x6012, 0x9A);
+
+        CHECK(banked.prg_ram[0x12] == 0x9A);
+        CHECK(bus.read(0x6012) == 0x9A);
+        CHECK(banked.bank == 0);
+    }
+    SECTION("bank switching remaps the pages") {
+        bus.write(0x8000, 0x01);
+
+        CHECK(bus.read(0x8034) == 0x78);
+    }
+    SECTION("ejecting the cartridge unmaps its pages") {
+        bus.eject_cartridge();
+
+        CHECK(bus.read(0x8034) == 0x00);
+    }
+}
+
+TEST_CASE_METHOD(bus_test, "Bus - over a concrete cartridge type") {
+    auto typed_bus = nes::console_bus<test_ppu, test_cartridge>{ppu, &cartridge};
+
+    SECTION("the PPU gets the same cartridge") {
+        CHECK(ppu.cartridge == &cartridge);
+        CHECK(typed_bus.cartridge() == &cartridge);
+    }
+    SECTION("cartridge writes reach the mapper") {
+        typed_bus.write(0x8000, 0x42);
+
+        CHECK(cartridge.bytes_written.at(0x8000) == 0x42);
+    }
+}
+
+TEST_CASE("Bus - a CHR bank switch in the middle of a line") {
+    struct frame_screen {
+        std::array<nes::color, 256 * 240> pixels{};
+
+        [[nodiscard]] constexpr static auto width() -> short { return 256; }
+        [[nodiscard]] constexpr static auto height() -> short { return 240; }
+
+        void draw_pixel(nes::point where, nes::color color) {
+            if (where.x >= 0 and where.x < width() and where.y >= 0 and where.y < height())
+                pixels[where.y * 256 + where.x] = color;
+        }
+
+        [[nodiscard]] auto at(int x, int y) const { return pixels[y * 256 + x]; }
+    };
+
+    // Tile 0 is all pixel 1 in bank 0 and all pixel 2 in bank 1
+    auto chr = std::vector<nes::membank<4_Kb>>(2);
+    std::fill_n(chr[0].begin(), 8, std::uint8_t{0xFF});
+    std::fill_n(chr[1].begin() + 8, 8, std::uint8_t{0xFF});
+
+    auto cartridge = nes::mmc1{std::vector<nes::membank<16_Kb>>(2), chr};
+    auto screen = frame_screen{};
+    auto ppu = nes::basic_ppu<nes::mmc1>{nes::DEFAULT_COLORS};
+    auto bus = nes::console_bus<nes::basic_ppu<nes::mmc1>, nes::mmc1>{ppu, &cartridge};
+
+    auto dot = std::uint64_t{0};
+    bus.catch_up = [&](auto cycle) {
+        for (; dot < cycle * 3; ++dot)
+            ppu.tick_old(screen);
+    };
+
+    // An MMC1 register takes five writes, a bit each, on separate cycles
+    auto write_mmc1 = [&bus](std::uint16_t addr, std::uint8_t value) {
+        for (auto bit = 0; bit < 5; ++bit) {
+            bus.advance(2);
+            bus.write(addr, static_cast<std::uint8_t>(value >> bit));
+        }
+    };
+
+    write_mmc1(0x8000, 0x1C);// 4Kb CHR banks
+    write_mmc1(0xA000, 0);
+
+    for (auto [addr, value]: std::to_array<std::pair<std::uint16_t, std::uint8_t>>(
+             {{0x2006, 0x3F}, {0x2006, 0x00}, {0x2007, 0x0F}, {0x2007, 0x16}, {0x2007, 0x2A},
+              {0x2000, 0x00}, {0x2005, 0x00}, {0x2005, 0x00}, {0x2001, 0x0A}}))
+        bus.write(addr, value);
+
+    // The last of the five writes lands on line 10, dot 131
+    bus.advance(static_cast<int>((11 * 341 + 131) / 3 - 10 - bus.cycle()));
+    write_mmc1(0xA000, 1);
+
+    bus.advance(static_cast<int>(ppu.frame_dots() / 3 - bus.cycle()));
+    bus.catch_up(bus.cycle());
+
+    const auto bank0 = nes::DEFAULT_COLORS[0x16];
+    const auto bank1 = nes::DEFAULT_COLORS[0x2A];
+
+    CHECK(screen.at(200, 9) == bank0);
+    CHECK(screen.at(100, 10) == bank0);
+    CHECK(screen.at(200, 10) == bank1);
+    CHECK(screen.at(100, 11) == bank1);
+}
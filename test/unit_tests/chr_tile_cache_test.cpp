@@ -0,0 +1,50 @@
+#include <libnes/chr_tile_cache.hpp>
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <random>
+
+using namespace nes::literals;
+
+TEST_CASE("CHR tile rows") {
+    SECTION("each pixel takes its low bit from the first plane") {
+        CHECK(nes::decode_tile_row(0b1100'0011, 0b1010'0101) == std::array<std::uint8_t, 8>{3, 1, 2, 0, 0, 2, 1, 3});
+        CHECK(nes::decode_tile_row(0xFF, 0x00) == std::array<std::uint8_t, 8>{1, 1, 1, 1, 1, 1, 1, 1});
+        CHECK(nes::decode_tile_row(0x00, 0x01) == std::array<std::uint8_t, 8>{0, 0, 0, 0, 0, 0, 0, 2});
+    }
+
+    SECTION("a whole tile at once decodes as row by row") {
+        auto random = std::mt19937{7};
+        for (auto n = 0; n < 1000; ++n) {
+            auto planes = std::array<std::uint8_t, 16>{};
+            for (auto& byte: planes)
+                byte = static_cast<std::uint8_t>(random());
+
+            auto tile = nes::decode_tile(planes);
+            for (auto row = 0; row < 8; ++row) {
+                INFO("row " << row);
+                CHECK(std::ranges::equal(std::span{tile}.subspan(row * 8, 8), nes::decode_tile_row(planes[row], planes[row + 8])));
+            }
+        }
+    }
+}
+
+TEST_CASE("CHR tile cache") {
+    auto chr = std::array<std::uint8_t, 4_Kb>{};
+    chr[0x0123] = 0xF0;// tile 0x12, row 3
+    chr[0x012B] = 0x3C;
+
+    auto tiles = nes::chr_tile_cache{chr};
+
+    SECTION("rows are found by the address of their low plane") {
+        CHECK(std::ranges::equal(tiles.row(0x0123), std::array{1, 1, 3, 3, 2, 2, 0, 0}));
+        CHECK(std::ranges::equal(tiles.row(0x0122), std::array{0, 0, 0, 0, 0, 0, 0, 0}));
+    }
+
+    SECTION("a write to either plane decodes its row again") {
+        chr[0x012B] = 0xFF;
+        tiles.update(chr, 0x012B);
+
+        CHECK(std::ranges::equal(tiles.row(0x0123), std::array{3, 3, 3, 3, 2, 2, 2, 2}));
+    }
+}
@@ -0,0 +1,90 @@
+#include <catch2/catch_all.hpp>
+
+#include <libnes/cpu_disassembler.hpp>
+#include <libnes/cpu_opcodes.hpp>
+#include <libnes/cpu_trace.hpp>
+
+#include <array>
+
+TEST_CASE("Opcode table")
+{
+    SECTION("Lengths follow the addressing")
+    {
+        CHECK(nes::OPCODES[0xEA].length == 1);// NOP
+        CHECK(nes::OPCODES[0x0A].length == 1);// ASL A
+        CHECK(nes::OPCODES[0xA9].length == 2);// LDA #
+        CHECK(nes::OPCODES[0xB1].length == 2);// LDA (zp),Y
+        CHECK(nes::OPCODES[0xD0].length == 2);// BNE
+        CHECK(nes::OPCODES[0x6C].length == 3);// JMP (abs)
+        CHECK(nes::OPCODES[0x20].length == 3);// JSR
+        CHECK(nes::OPCODES[0x82].length == 2);// NOP #
+    }
+    SECTION("Only indexed reads and branches take the page crossing cycle")
+    {
+        CHECK(nes::OPCODES[0xBD].page_penalty);// LDA abs,X
+        CHECK(nes::OPCODES[0xB1].page_penalty);// LDA (zp),Y
+        CHECK(nes::OPCODES[0x10].page_penalty);// BPL
+        CHECK_FALSE(nes::OPCODES[0x9D].page_penalty);// STA abs,X
+        CHECK_FALSE(nes::OPCODES[0x1E].page_penalty);// ASL abs,X
+        CHECK_FALSE(nes::OPCODES[0xB5].page_penalty);// LDA zp,X
+    }
+    SECTION("Memory access classes")
+    {
+        CHECK(nes::OPCODES[0xAD].access == nes::memory_access::read);
+        CHECK(nes::OPCODES[0x8D].access == nes::memory_access::write);
+        CHECK(nes::OPCODES[0xEE].access == nes::memory_access::read_modify_write);
+        CHECK(nes::OPCODES[0xC3].access == nes::memory_access::read_modify_write);// DCP
+        CHECK(nes::OPCODES[0xA9].access == nes::memory_access::none);
+        CHECK(nes::OPCODES[0x0A].access == nes::memory_access::none);
+        CHECK(nes::OPCODES[0x4C].access == nes::memory_access::none);
+    }
+    SECTION("Unofficial opcodes")
+    {
+        CHECK(nes::OPCODES[0xE9].official);
+        CHECK_FALSE(nes::OPCODES[0xEB].official);// SBC #
+        CHECK_FALSE(nes::OPCODES[0x1A].official);// NOP
+        CHECK_FALSE(nes::OPCODES[0xA7].official);// LAX
+        CHECK(nes::OPCODES[0x02].mnemonic == nes::mnemonic::unsupported);
+    }
+}
+
+TEST_CASE("Disassembler")
+{
+    auto disassemble = [](std::uint16_t pc, auto... bytes) {
+        return nes::disassemble(pc, std::array{static_cast<std::uint8_t>(bytes)...});
+    };
+
+    CHECK(disassemble(0xC000, 0x4C, 0xF5, 0xC5) == "JMP $C5F5");
+    CHECK(disassemble(0xC000, 0xA9, 0x00) == "LDA #$00");
+    CHECK(disassemble(0xC000, 0x0A) == "ASL A");
+    CHECK(disassemble(0xC000, 0xEA) == "NOP");
+    CHECK(disassemble(0xC000, 0x9D, 0x00, 0x02) == "STA $0200,X");
+    CHECK(disassemble(0xC000, 0xB6, 0x10) == "LDX $10,Y");
+    CHECK(disassemble(0xC000, 0xA1, 0x80) == "LDA ($80,X)");
+    CHECK(disassemble(0xC000, 0xB1, 0x89) == "LDA ($89),Y");
+    CHECK(disassemble(0xC000, 0x6C, 0x00, 0x02) == "JMP ($0200)");
+    CHECK(disassemble(0xC000, 0x04, 0xA9) == "*NOP $A9");
+    CHECK(disassemble(0xC000, 0x82, 0x10) == "*NOP #$10");
+
+    SECTION("Branches show their target")
+    {
+        CHECK(disassemble(0xC72A, 0xD0, 0xE0) == "BNE $C70C");
+        CHECK(disassemble(0xC000, 0x10, 0x05) == "BPL $C007");
+    }
+    SECTION("Trace lines")
+    {
+        struct {
+            std::uint16_t pc;
+            std::uint8_t s, p, a, x, y;
+        } state{0xC000, 0xFD, 0x24, 0x00, 0x01, 0x02};
+
+        CHECK(nes::trace_line(state, std::array<std::uint8_t, 3>{0x4C, 0xF5, 0xC5})
+              == "C000  4C F5 C5  JMP $C5F5                       A:00 X:01 Y:02 P:24 SP:FD");
+        CHECK(nes::trace_line(state, std::array<std::uint8_t, 3>{0x04, 0xA9, 0x00})
+              == "C000  04 A9    *NOP $A9                         A:00 X:01 Y:02 P:24 SP:FD");
+
+        auto record = nes::trace_record{7, 0xC000, {0x4C, 0xF5, 0xC5}, 0x00, 0x01, 0x02, 0x24, 0xFD};
+        CHECK(nes::trace_line(record, record.bytes)
+              == "C000  4C F5 C5  JMP $C5F5                       A:00 X:01 Y:02 P:24 SP:FD CYC:7");
+    }
+}
@@ -4,6 +4,9 @@
 #include <libnes/literals.hpp>
 
 #include <array>
+#include <cstddef>
+#include <cstring>
+#include <sstream>
 
 using namespace nes::literals;
 
@@ -64,6 +67,49 @@ TEST_CASE_METHOD(cpu_test, "Power Up")
     CHECK(cpu.s.value() == 0xfd);
 }
 
+TEST_CASE("Flags register")
+{
+    auto p = nes::flags_register{};
+
+    SECTION("N and Z follow the last result")
+    {
+        p.set_nz(0x00);
+        CHECK(p.test(nes::cpu_flag::zero));
+        CHECK_FALSE(p.test(nes::cpu_flag::negative));
+        CHECK((int)p.value() == 0x22);
+
+        p.set_nz(0x80);
+        CHECK_FALSE(p.test(nes::cpu_flag::zero));
+        CHECK(p.test(nes::cpu_flag::negative));
+        CHECK((int)p.value() == 0xA0);
+    }
+    SECTION("N and Z can both be set")
+    {
+        p.assign(0x82);
+        CHECK(p.test(nes::cpu_flag::zero));
+        CHECK(p.test(nes::cpu_flag::negative));
+        CHECK((int)p.value() == 0xA2);
+    }
+    SECTION("Setting one of N and Z keeps the other")
+    {
+        p.set_nz(0x00);
+        p.set(nes::cpu_flag::negative);
+        CHECK(p.test(nes::cpu_flag::zero));
+        CHECK(p.test(nes::cpu_flag::negative));
+
+        p.reset(nes::cpu_flag::zero);
+        CHECK_FALSE(p.test(nes::cpu_flag::zero));
+        CHECK(p.test(nes::cpu_flag::negative));
+    }
+    SECTION("Other flags are kept as they are")
+    {
+        p.set_nz(0x00);
+        p.set(nes::cpu_flag::carry);
+        p.set(nes::cpu_flag::overflow);
+        CHECK((int)p.value() == 0x63);
+    }
+}
+
 TEST_CASE_METHOD(cpu_test, "read_word")
 {
     load(0x0017, std::array{0x10, 0xd0}); // $D010
@@ -1606,6 +1652,89 @@ TEST_CASE_METHOD(cpu_test, "NMI")
     CHECK(cpu.pc.value() == 0xb000);
 }
 
+TEST_CASE_METHOD(cpu_test, "Step")
+{
+    SECTION("Executes a whole instruction")
+    {
+        load(prgadr, std::array{0xa9, 0x55}); // LDA #$55
+
+        CHECK(cpu.step() == 2);
+        CHECK(cpu.a.value() == 0x55);
+        CHECK(cpu.pc.value() == prgadr + 2);
+        CHECK_FALSE(cpu.is_executing());
+    }
+    SECTION("Counts page crossing")
+    {
+        load(prgadr, std::array{0xbd, 0x0A, 0xd0}); // LDA $D00A,X
+        load(0xd109, std::array{0x43});
+        cpu.x.assign(0xff);
+
+        CHECK(cpu.step() == 5);
+        CHECK(cpu.a.value() == 0x43);
+    }
+    SECTION("Counts a taken branch")
+    {
+        load(prgadr, std::array{0x10, 0x10}); // BPL +$10
+
+        CHECK(cpu.step() == 3);
+        CHECK(cpu.pc.value() == prgadr + 0x12);
+    }
+    SECTION("Executes consecutive instructions")
+    {
+        load(prgadr, std::array{0xa2, 0x01, 0xe8, 0x86, 0x10}); // LDX #$01; INX; STX $10
+
+        CHECK(cpu.step() == 2);
+        CHECK(cpu.step() == 2);
+        CHECK(cpu.step() == 3);
+        CHECK((int)mem[0x0010] == 0x02);
+    }
+    SECTION("Finishes an instruction started by tick")
+    {
+        load(prgadr, std::array{0xad, 0x10, 0xd0, 0xa9, 0x55}); // LDA $D010; LDA #$55
+        load(0xd010, std::array{0x42});
+
+        tick(1, false);
+
+        CHECK(cpu.step() == 3);
+        CHECK(cpu.a.value() == 0x42);
+
+        CHECK(cpu.step() == 2);
+        CHECK(cpu.a.value() == 0x55);
+    }
+    SECTION("Takes the NMI")
+    {
+        load(0xfffa, std::array{0x00, 0xb0});
+        trigger_nmi();
+
+        CHECK(cpu.step() == 8);
+        CHECK(cpu.pc.value() == 0xb000);
+    }
+}
+
+TEST_CASE_METHOD(cpu_test, "Fused instructions")
+{
+    // LDX #$05; l1: DEX; BNE l1; LDY #$00; l2: LDA $0200,Y; STA $0300,Y; INY; CPY #$04; BNE l2; end: JMP end
+    load(prgadr, std::array{
+        0xa2, 0x05, 0xca, 0xd0, 0xfd, 0xa0, 0x00, 0xb9, 0x00, 0x02, 0x99, 0x00, 0x03,
+        0xc8, 0xc0, 0x04, 0xd0, 0xf5, 0x4c, 0x12, 0x80});
+    load(0x0200, std::array{0x11, 0x22, 0x33, 0x44});
+
+    SECTION("Take as many cycles as one by one")
+    {
+        CHECK(cpu.run(2 + (5 * 2 + 4 * 3 + 2) + 2 + (4 * 13 + 3 * 3 + 2)) == 91);
+        CHECK(cpu.pc.value() == 0x8012);
+        CHECK(cpu.x.value() == 0x00);
+        CHECK((int)mem[0x0300] == 0x11);
+        CHECK((int)mem[0x0303] == 0x44);
+    }
+    SECTION("Stop in between when the cycles run out")
+    {
+        CHECK(cpu.run(4) == 4);
+        CHECK(cpu.pc.value() == 0x8003);
+        CHECK(cpu.x.value() == 0x04);
+    }
+}
+
 TEST_CASE_METHOD(cpu_test, "Save state")
 {
     SECTION("Save registers")
@@ -1685,4 +1814,544 @@ TEST_CASE_METHOD(cpu_test, "Save state")
         CHECK(cpu.a.value() == 0x55);
         CHECK(cpu.pc.value() == prgadr + 2);
     }
-}
\ No newline at end of file
+    SECTION("Copy as bytes")
+    {
+        load(prgadr, std::array{0xa9, 0x55}); // LDA #$55
+        tick(1, false);
+
+        auto bytes = std::array<std::byte, sizeof(nes::cpu<test_bus>::state)>{};
+        auto saved = cpu.save_state();
+        std::memcpy(bytes.data(), &saved, sizeof(saved));
+
+        CHECK(int(saved.opcode) == 0xa9);
+        CHECK_FALSE(saved.interrupt);
+        CHECK(int(saved.cycles_left) == 1);
+
+        tick(1);
+        cpu.a.assign(0x02);
+
+        auto state = nes::cpu<test_bus>::state{};
+        std::memcpy(&state, bytes.data(), sizeof(state));
+        cpu.load_state(state);
+
+        CHECK(std::memcmp(bytes.data(), &state, sizeof(state)) == 0);
+
+        tick(1);
+
+        CHECK(cpu.a.value() == 0x55);
+        CHECK(cpu.pc.value() == prgadr + 2);
+    }
+}
+
+TEST_CASE("Predecoded code")
+{
+    // Maps $8000-$FFFF read-only, from the bank selected through $2000
+    struct code_bus
+    {
+        void write(std::uint16_t addr, std::uint8_t value)
+        {
+            if (addr == 0x2000)
+                bank = value & 0x01;
+            mem[addr] = value;
+        }
+        std::uint8_t read(std::uint16_t addr) const { return addr >= 0x8000 ? rom[bank][addr - 0x8000] : mem[addr]; }
+
+        bool nmi() const { return false; }
+
+        auto code_page(std::uint8_t page) const -> const std::uint8_t*
+        {
+            return page >= 0x80 ? rom[bank].data() + (page - 0x80) * 0x100 : nullptr;
+        }
+
+        std::vector<std::uint8_t> mem = std::vector<std::uint8_t>(32_Kb, 0);
+        std::array<std::vector<std::uint8_t>, 2> rom{create_memory(), create_memory()};
+        std::size_t bank{0};
+    };
+
+    auto bus = code_bus{};
+    auto load = [&bus](std::size_t bank, std::uint16_t addr, auto program) {
+        std::ranges::copy(program, bus.rom[bank].begin() + (addr - 0x8000));
+    };
+    for (auto& rom: bus.rom)
+        rom.resize(32_Kb);
+    load(0, 0xfffc, std::array{0x00, 0x80});
+
+    SECTION("Runs a loop as the interpreter does")
+    {
+        // LDX #$05; loop: DEX; BNE loop; STX $10; LDA #$01
+        load(0, 0x8000, std::array{0xa2, 0x05, 0xca, 0xd0, 0xfd, 0x86, 0x10, 0xa9, 0x01});
+        auto cpu = nes::cpu<code_bus>{bus};
+
+        auto cycles = 0;
+        while (cpu.pc.value() != 0x8009)
+            cycles += cpu.step();
+
+        CHECK(cycles == 2 + 5 * 2 + 4 * 3 + 2 + 3 + 2);
+        CHECK(cpu.x.value() == 0x00);
+        CHECK(cpu.a.value() == 0x01);
+        CHECK((int)bus.mem[0x0010] == 0x00);
+    }
+    SECTION("Runs whole instructions until the cycles are spent")
+    {
+        load(0, 0x8000, std::array{0xa9, 0x01, 0x85, 0x10, 0xe8, 0xe8}); // LDA #$01; STA $10; INX; INX
+        auto cpu = nes::cpu<code_bus>{bus};
+
+        CHECK(cpu.run(4) == 5);
+        CHECK(cpu.pc.value() == 0x8004);
+        CHECK((int)bus.mem[0x0010] == 0x01);
+
+        CHECK(cpu.run(1) == 2);
+        CHECK(cpu.x.value() == 0x01);
+    }
+    SECTION("Follows a bank switch")
+    {
+        load(0, 0x8000, std::array{0xa9, 0x01, 0x8d, 0x00, 0x20, 0xa9, 0x02}); // LDA #$01; STA $2000; LDA #$02
+        load(1, 0x8000, std::array{0xa9, 0x01, 0x8d, 0x00, 0x20, 0xa9, 0x03}); // ...; LDA #$03
+        auto cpu = nes::cpu<code_bus>{bus};
+
+        CHECK(cpu.run(8) == 8);
+        CHECK(cpu.a.value() == 0x03);
+    }
+    SECTION("An unsupported opcode leaves the operands after it to the bus")
+    {
+        load(0, 0x8000, std::array{0x02, 0xa9, 0x01}); // $02, unsupported; LDA #$01
+        auto cpu = nes::cpu<code_bus>{bus};
+
+        CHECK_THROWS_AS(cpu.step(), nes::unsupported_opcode);
+
+        cpu.tick();
+        cpu.tick();
+        CHECK(cpu.a.value() == 0x01);
+    }
+}
+
+TEST_CASE("Idle loops")
+{
+    // $2002 reads $80 from `flag_cycle` on, and that is the only thing
+    // that ever changes by itself
+    struct idle_bus
+    {
+        void write(std::uint16_t addr, std::uint8_t value) { mem[addr] = value; }
+        std::uint8_t read(std::uint16_t addr)
+        {
+            if (addr != 0x2002)
+                return mem[addr];
+
+            ++polls;
+            return cycle_ >= flag_cycle ? 0x80 : 0x00;
+        }
+
+        bool nmi() const { return false; }
+
+        void advance(int cycles) { cycle_ += cycles; }
+        auto cycle() const -> std::uint64_t { return cycle_; }
+        auto idle_until() const -> std::uint64_t { return cycle_ < flag_cycle ? flag_cycle : UINT64_MAX; }
+        bool is_pollable(std::uint16_t addr) const { return addr < 0x2000 or addr == 0x2002; }
+
+        std::vector<std::uint8_t> mem = create_memory();
+        std::uint64_t cycle_{0};
+        std::uint64_t flag_cycle{10000};
+        int polls{0};
+    };
+
+    auto run = [](auto program, bool skip_idle_loops) {
+        auto bus = idle_bus{};
+        std::ranges::copy(program, bus.mem.begin() + 0x8000);
+
+        auto cpu = nes::cpu<idle_bus>{bus};
+        cpu.skip_idle_loops(skip_idle_loops);
+
+        auto cycles = cpu.run(20000);
+        return std::tuple{cycles, bus.cycle(), bus.polls, bus.mem[0x0010], cpu.pc.value()};
+    };
+
+    SECTION("A polling loop is skipped up to when the flag comes up")
+    {
+        // loop: LDA $2002; BPL loop; STA $10; end: JMP end
+        auto program = std::array<std::uint8_t, 10>{0xad, 0x02, 0x20, 0x10, 0xfb, 0x85, 0x10, 0x4c, 0x07, 0x80};
+
+        auto [cycles, cycle, polls, stored, pc] = run(program, true);
+        auto [cycles_run, cycle_run, polls_run, stored_run, pc_run] = run(program, false);
+
+        CHECK(cycles == cycles_run);
+        CHECK(cycle == cycle_run);
+        CHECK(stored == stored_run);
+        CHECK((int)stored == 0x80);
+        CHECK(pc == pc_run);
+        CHECK(polls < 5);
+        CHECK(polls_run > 1000);
+    }
+    SECTION("Is off by default")
+    {
+        auto bus = idle_bus{};
+        std::ranges::copy(std::array{0xad, 0x02, 0x20, 0x10, 0xfb}, bus.mem.begin() + 0x8000);
+
+        auto cpu = nes::cpu<idle_bus>{bus};
+        cpu.run(1000);
+
+        CHECK(bus.polls > 100);
+    }
+    SECTION("A loop that writes is run through")
+    {
+        // loop: INC $10; LDA $2002; BPL loop; end: JMP end
+        auto program = std::array<std::uint8_t, 10>{0xe6, 0x10, 0xad, 0x02, 0x20, 0x10, 0xf9, 0x4c, 0x07, 0x80};
+
+        auto [cycles, cycle, polls, stored, pc] = run(program, true);
+        auto [cycles_run, cycle_run, polls_run, stored_run, pc_run] = run(program, false);
+
+        CHECK(cycles == cycles_run);
+        CHECK(stored == stored_run);
+        CHECK(pc == pc_run);
+        CHECK(polls == polls_run);
+    }
+}
+
+TEST_CASE("Bus timing")
+{
+    // Records every access with the cycle it happens on
+    struct timing_bus
+    {
+        struct access
+        {
+            std::uint64_t cycle;
+            nes::bus_cycle type;
+            std::uint16_t addr;
+            std::uint8_t value;
+        };
+
+        void write(std::uint16_t addr, std::uint8_t value)
+        {
+            accesses.push_back({cycle, nes::bus_cycle::write, addr, value});
+            mem[addr] = value;
+        }
+        std::uint8_t read(std::uint16_t addr)
+        {
+            accesses.push_back({cycle, nes::bus_cycle::read, addr, mem[addr]});
+            return mem[addr];
+        }
+
+        bool nmi() const { return false; }
+
+        void advance(int cycles) { cycle += cycles; }
+
+        std::vector<std::uint8_t> mem = create_memory();
+        std::uint64_t cycle{0};
+        std::vector<access> accesses;
+    };
+
+    SECTION("Every access lands on a cycle the opcode table has for it")
+    {
+        for (auto opcode = 0; opcode < 0x100; ++opcode) {
+            auto info = nes::OPCODES[opcode];
+            if (info.mnemonic == nes::mnemonic::unsupported)
+                continue;
+
+            // The operand is $0010 and the registers are zero: no page gets
+            // crossed
+            auto bus = timing_bus{};
+            std::ranges::copy(std::array{opcode, 0x10, 0x00}, bus.mem.begin() + 0x8000);
+            auto cpu = nes::cpu<timing_bus>{bus};
+            bus.accesses.clear();
+
+            auto cycles = cpu.step();
+            auto schedule = nes::bus_cycles(info);
+
+            CAPTURE(opcode);
+            if (info.addressing != nes::addressing::rel)
+                CHECK(cycles == schedule.length);
+
+            for (const auto& access: bus.accesses) {
+                REQUIRE(access.cycle < static_cast<std::uint64_t>(schedule.length));
+                CHECK(access.type == schedule.cycles[access.cycle]);
+            }
+        }
+    }
+    SECTION("A read-modify-write writes back what it read, then the result")
+    {
+        auto bus = timing_bus{};
+        std::ranges::copy(std::array{0xee, 0x10, 0x00}, bus.mem.begin() + 0x8000); // INC $0010
+        bus.mem[0x0010] = 0x05;
+        auto cpu = nes::cpu<timing_bus>{bus};
+        bus.accesses.clear();
+
+        CHECK(cpu.step() == 6);
+        REQUIRE(bus.accesses.size() == 6);
+        CHECK(bus.accesses[3].type == nes::bus_cycle::read);
+        CHECK((int)bus.accesses[4].value == 0x05);
+        CHECK(bus.accesses[4].cycle == 4);
+        CHECK((int)bus.accesses[5].value == 0x06);
+        CHECK(bus.accesses[5].cycle == 5);
+    }
+    SECTION("Indexing across a page reads before the carry first")
+    {
+        auto bus = timing_bus{};
+        std::ranges::copy(std::array{0xbd, 0xff, 0x20}, bus.mem.begin() + 0x8000); // LDA $20FF,X
+        auto cpu = nes::cpu<timing_bus>{bus};
+        cpu.x.assign(0x01);
+        bus.accesses.clear();
+
+        CHECK(cpu.step() == 5);
+        REQUIRE(bus.accesses.size() == 5);
+        CHECK(bus.accesses[3].addr == 0x2000);
+        CHECK(bus.accesses[4].addr == 0x2100);
+        CHECK(bus.accesses[4].cycle == 4);
+    }
+    SECTION("A store reads the address before the carry, crossing or not")
+    {
+        auto bus = timing_bus{};
+        std::ranges::copy(std::array{0x9d, 0x00, 0x20}, bus.mem.begin() + 0x8000); // STA $2000,X
+        auto cpu = nes::cpu<timing_bus>{bus};
+        cpu.x.assign(0x07);
+        bus.accesses.clear();
+
+        CHECK(cpu.step() == 5);
+        REQUIRE(bus.accesses.size() == 5);
+        CHECK(bus.accesses[3].type == nes::bus_cycle::read);
+        CHECK(bus.accesses[3].addr == 0x2007);
+        CHECK(bus.accesses[4].type == nes::bus_cycle::write);
+    }
+    SECTION("An unsupported opcode leaves the accesses untimed after it")
+    {
+        auto bus = timing_bus{};
+        std::ranges::copy(std::array{0x02, 0xa9, 0x01}, bus.mem.begin() + 0x8000); // $02, unsupported; LDA #$01
+        auto cpu = nes::cpu<timing_bus>{bus};
+
+        CHECK_THROWS_AS(cpu.step(), nes::unsupported_opcode);
+
+        // Cycle by cycle, tick() advances the clock itself
+        auto cycle = bus.cycle;
+        cpu.tick();
+        cpu.tick();
+        CHECK(bus.cycle == cycle + 2);
+        CHECK((int)cpu.a.value() == 0x01);
+    }
+}
+
+TEST_CASE("Zero page and stack")
+{
+    // Hands out its RAM, and records the addresses it is asked for
+    struct ram_bus
+    {
+        void write(std::uint16_t addr, std::uint8_t value)
+        {
+            accessed.push_back(addr);
+            mem[addr] = value;
+        }
+        std::uint8_t read(std::uint16_t addr)
+        {
+            accessed.push_back(addr);
+            return mem[addr];
+        }
+
+        bool nmi() const { return false; }
+
+        void advance(int cycles) { cycle += cycles; }
+
+        std::uint8_t* ram() { return mem.data(); }
+
+        std::vector<std::uint8_t> mem = create_memory();
+        std::uint64_t cycle{0};
+        std::vector<std::uint16_t> accessed;
+    };
+
+    static_assert(nes::ram_bus<ram_bus>);
+
+    auto bus = ram_bus{};
+    std::ranges::copy(std::array{
+        0xa5, 0x10,       // LDA $10
+        0xe6, 0x11,       // INC $11
+        0xb1, 0x20,       // LDA ($20),Y
+        0x48,             // PHA
+        0x20, 0x00, 0x90, // JSR $9000
+        0x68,             // PLA
+    }, bus.mem.begin() + 0x8000);
+    bus.mem[0x9000] = 0x60; // RTS
+    bus.mem[0x0010] = 0x42;
+    bus.mem[0x0011] = 0x07;
+    std::ranges::copy(std::array{0xff, 0x03}, bus.mem.begin() + 0x0020);
+    bus.mem[0x0400] = 0x99;
+
+    auto cpu = nes::cpu<ram_bus>{bus};
+    cpu.y.assign(0x01);
+    bus.accessed.clear();
+
+    CHECK(cpu.step() == 3);
+    CHECK((int)cpu.a.value() == 0x42);
+    CHECK(cpu.step() == 5);
+    CHECK((int)bus.mem[0x0011] == 0x08);
+    CHECK(cpu.step() == 6);
+    CHECK((int)cpu.a.value() == 0x99);
+    CHECK(cpu.step() == 3);
+    CHECK((int)bus.mem[0x01fd] == 0x99);
+    CHECK(cpu.step() == 6);
+    CHECK(cpu.pc.value() == 0x9000);
+    CHECK(cpu.step() == 6);
+    CHECK(cpu.pc.value() == 0x800a);
+    cpu.a.assign(0x00);
+    CHECK(cpu.step() == 4);
+    CHECK((int)cpu.a.value() == 0x99);
+    CHECK(cpu.s.value() == 0xfd);
+    CHECK(bus.cycle == 33);
+
+    CHECK(std::ranges::none_of(bus.accessed, [](auto addr) { return addr < 0x0200; }));
+}
+
+TEST_CASE("Interrupt lines")
+{
+    // Raises an NMI when the stack is written at `nmi_at`
+    struct interrupt_bus
+    {
+        void write(std::uint16_t addr, std::uint8_t value)
+        {
+            if (addr == nmi_at)
+                lines.raise_nmi();
+            mem[addr] = value;
+        }
+        std::uint8_t read(std::uint16_t addr) { return mem[addr]; }
+
+        nes::interrupt_lines& interrupts() { return lines; }
+
+        std::vector<std::uint8_t> mem = create_memory();
+        nes::interrupt_lines lines;
+        std::uint16_t nmi_at{0};
+    };
+
+    static_assert(nes::interrupt_bus<interrupt_bus>);
+
+    auto bus = interrupt_bus{};
+    std::ranges::copy(std::array{0x00, 0xa0, 0x00, 0x80, 0x00, 0xb0}, bus.mem.begin() + 0xfffa); // NMI $A000, IRQ $B000
+    std::ranges::copy(std::array{0xea, 0xea, 0xea}, bus.mem.begin() + 0x8000); // NOP; NOP; NOP
+    auto cpu = nes::cpu<interrupt_bus>{bus};
+
+    SECTION("The IRQ is taken while the I flag is clear, for as long as it's held")
+    {
+        cpu.p.reset(nes::cpu_flag::int_disable);
+        bus.lines.set_irq(nes::irq_source::mapper, true);
+
+        CHECK(cpu.step() == 8);
+        CHECK(cpu.pc.value() == 0xb000);
+        CHECK(cpu.p.test(nes::cpu_flag::int_disable));
+        CHECK((int)bus.mem[0x01fb] == 0x20); // B clear
+        CHECK((int)bus.mem[0x01fc] == 0x00);
+        CHECK((int)bus.mem[0x01fd] == 0x80);
+
+        cpu.p.reset(nes::cpu_flag::int_disable);
+        CHECK(cpu.step() == 8);
+        CHECK(cpu.pc.value() == 0xb000);
+    }
+    SECTION("The I flag masks the IRQ")
+    {
+        cpu.p.set(nes::cpu_flag::int_disable);
+        bus.lines.set_irq(nes::irq_source::frame_counter, true);
+
+        CHECK(cpu.step() == 2);
+        CHECK(cpu.pc.value() == 0x8001);
+    }
+    SECTION("The NMI is taken once per edge, I flag or not")
+    {
+        cpu.p.set(nes::cpu_flag::int_disable);
+        bus.lines.raise_nmi();
+
+        CHECK(cpu.step() == 8);
+        CHECK(cpu.pc.value() == 0xa000);
+
+        cpu.pc.assign(0x8000);
+        CHECK(cpu.step() == 2);
+        CHECK(cpu.pc.value() == 0x8001);
+    }
+    SECTION("An NMI coming in while an IRQ pushes hijacks its vector")
+    {
+        cpu.p.reset(nes::cpu_flag::int_disable);
+        bus.lines.set_irq(nes::irq_source::dmc, true);
+        bus.nmi_at = 0x01fb;
+
+        CHECK(cpu.step() == 8);
+        CHECK(cpu.pc.value() == 0xa000);
+        CHECK_FALSE(bus.lines.nmi());
+    }
+    SECTION("An NMI coming in while BRK pushes hijacks its vector")
+    {
+        bus.mem[0x8000] = 0x00; // BRK
+        bus.nmi_at = 0x01fb;
+
+        CHECK(cpu.step() == 7);
+        CHECK(cpu.pc.value() == 0xa000);
+        CHECK_FALSE(bus.lines.nmi());
+    }
+}
+
+#ifdef LIBNES_PROFILE
+TEST_CASE_METHOD(cpu_test, "Profile")
+{
+    load(prgadr, std::array{0xa2, 0x03, 0xca, 0xd0, 0xfd}); // LDX #$03; l1: DEX; BNE l1
+
+    CHECK(cpu.run(2 + 3 * 2 + 3 + 3 + 2) == 16);
+
+    SECTION("Counts instructions and cycles per address")
+    {
+        CHECK(cpu.profile().at(0x8002).instructions == 3);
+        CHECK(cpu.profile().at(0x8002).cycles == 6);
+        CHECK(cpu.profile().at(0x8003).instructions == 3);
+        CHECK(cpu.profile().at(0x8003).cycles == 8);
+        CHECK(cpu.profile().at(0x8004).instructions == 0);
+    }
+    SECTION("Counts instructions and cycles per opcode")
+    {
+        CHECK(cpu.profile().of_opcode(0xa2).instructions == 1);
+        CHECK(cpu.profile().of_opcode(0xd0).cycles == 8);
+    }
+    SECTION("Dumps as CSV")
+    {
+        auto csv = std::ostringstream{};
+        cpu.profile().write_csv(csv);
+
+        CHECK(csv.str().contains("opcode,,,CA,DEX,3,6\n"));
+        CHECK(csv.str().contains("address,0,8003,D0,BNE,3,8\n"));
+    }
+    SECTION("Starts over when cleared")
+    {
+        cpu.clear_profile();
+        CHECK(cpu.profile().at(0x8002).instructions == 0);
+        CHECK(cpu.profile().of_opcode(0xca).instructions == 0);
+    }
+}
+
+TEST_CASE("Profile - banks")
+{
+    // Maps one of two banks at $8000-$80FF
+    struct banked_bus
+    {
+        void write(std::uint16_t, std::uint8_t) {}
+        std::uint8_t read(std::uint16_t addr) { return addr >> 8 == 0x80 ? banks[bank][addr & 0xFF] : mem[addr]; }
+        bool nmi() const { return false; }
+
+        const std::uint8_t* mapped_page(std::uint8_t page) const
+        {
+            return page == 0x80 ? banks[bank].data() : nullptr;
+        }
+
+        std::vector<std::uint8_t> mem = create_memory();
+        std::array<std::array<std::uint8_t, 0x100>, 2> banks{};
+        int bank{0};
+    };
+
+    static_assert(nes::mapped_bus<banked_bus>);
+
+    auto bus = banked_bus{};
+    bus.banks[0][0] = 0xea; // NOP
+    bus.banks[1][0] = 0xe8; // INX
+    auto cpu = nes::cpu<banked_bus>{bus};
+
+    cpu.step();
+    bus.bank = 1;
+    cpu.pc.assign(0x8000);
+    cpu.step();
+
+    CHECK(cpu.profile().at(0x8000).instructions == 2);
+
+    auto csv = std::ostringstream{};
+    cpu.profile().write_csv(csv);
+    CHECK(csv.str().contains("address,0,8000,EA,NOP,1,2\n"));
+    CHECK(csv.str().contains("address,1,8000,E8,INX,1,2\n"));
+}
+#endif
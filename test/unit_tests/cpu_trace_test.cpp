@@ -0,0 +1,46 @@
+#include <catch2/catch_all.hpp>
+
+#include <libnes/cpu_trace.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+TEST_CASE("Trace recorder") {
+    auto first = nes::trace_record{7, 0xC000, {0x4C, 0xF5, 0xC5}, 0x00, 0x00, 0x00, 0x24, 0xFD};
+    auto second = nes::trace_record{10, 0xC5F5, {0xA2, 0x00, 0x00}, 0x00, 0x00, 0x00, 0x24, 0xFD};
+
+    const auto filename = std::filesystem::temp_directory_path() / "trace_test.trace";
+
+    {
+        auto recorder = nes::trace_recorder{filename.string(), 4};
+        recorder.record(first);
+        recorder.record(second);
+    }
+
+    SECTION("writes every record out by the time it's gone") {
+        auto file = std::ifstream{filename, std::ifstream::binary};
+        auto records = std::vector<nes::trace_record>(3);
+        file.read(reinterpret_cast<char*>(records.data()), 3 * sizeof(nes::trace_record));
+
+        REQUIRE(file.gcount() == 2 * sizeof(nes::trace_record));
+        CHECK(records[0].cycle == 7);
+        CHECK(records[0].pc == 0xC000);
+        CHECK(records[1].bytes == std::array<std::uint8_t, 3>{0xA2, 0x00, 0x00});
+    }
+
+    SECTION("reads back as nestest.log has it") {
+        auto file = std::ifstream{filename, std::ifstream::binary};
+        auto log = std::ostringstream{};
+        nes::write_nestest_log(file, log);
+
+        CHECK(log.str() ==
+              "C000  4C F5 C5  JMP $C5F5                       A:00 X:00 Y:00 P:24 SP:FD CYC:7\n"
+              "C5F5  A2 00     LDX #$00                        A:00 X:00 Y:00 P:24 SP:FD CYC:10\n");
+    }
+    SECTION("can't be opened on a file it can't write") {
+        CHECK_THROWS_AS(nes::trace_recorder("no/such/directory/trace"), std::runtime_error);
+    }
+
+    std::filesystem::remove(filename);
+}
@@ -3,6 +3,9 @@
 
 #include <libnes/mappers/mmc1.hpp>
 
+#include <algorithm>
+#include <array>
+
 using namespace nes::literals;
 
 TEST_CASE("MMC1 registers") {
@@ -130,6 +133,41 @@ TEST_CASE("Mapper MMC1") {
     }
 }
 
+TEST_CASE("Mapper MMC1 PRG pages") {
+    auto prg = std::vector<nes::membank<16_Kb>>{{}, {}, {}};
+    auto chr = std::vector<nes::membank<4_Kb>>{{}, {}};
+
+    prg[0][0] = 'a';
+    prg[1][0] = 'b';
+    prg[2][0] = 'c';
+
+    auto cartridge = nes::mmc1{prg, chr};
+
+    SECTION("At creation the last bank is fixed at $C000") {
+        CHECK(*cartridge.read_page(0x80) == 'a');
+        CHECK(*cartridge.read_page(0xC0) == 'c');
+    }
+
+    SECTION("Bank switching remaps the $8000 pages") {
+        write(cartridge, 0xE000, 1);
+
+        CHECK(*cartridge.read_page(0x80) == 'b');
+        CHECK(*cartridge.read_page(0xBF) == cartridge.read(0xBF00));
+    }
+
+    SECTION("PRG RAM pages are writable") {
+        cartridge.write_page(0x61)[0x23] = 0x42;
+
+        CHECK(cartridge.read(0x6123) == 0x42);
+        CHECK(cartridge.read_page(0x61) == cartridge.write_page(0x61));
+    }
+
+    SECTION("Nothing is mapped below $6000") {
+        CHECK(cartridge.read_page(0x41) == nullptr);
+        CHECK(cartridge.write_page(0x80) == nullptr);
+    }
+}
+
 TEST_CASE("Mapper MMC1 with CHR RAM") {
     auto prg = std::vector<nes::membank<16_Kb>>{{}, {}};
     auto no_chr_rom = std::vector<nes::membank<4_Kb>>{};
@@ -198,6 +236,25 @@ TEST_CASE("Mapper MMC1 with CHR RAM") {
         write(cartridge, 0xA000, 0);// switch the window back to bank 0
         CHECK(cartridge.chr_read(0x0000) == 0x00);// untouched
     }
+
+    SECTION("CHR RAM writes show in the decoded tiles") {
+        cartridge.chr_write(0x0013, 0b1100'0011);// tile 1, row 3, low plane
+        cartridge.chr_write(0x001B, 0b1010'0101);// and its high plane
+
+        CHECK(std::ranges::equal(cartridge.chr_row(0x0013), std::array{3, 1, 2, 0, 0, 2, 1, 3}));
+        CHECK(std::ranges::equal(cartridge.chr_row(0x0012), std::array{0, 0, 0, 0, 0, 0, 0, 0}));
+    }
+
+    SECTION("Decoded tiles follow bank switching") {
+        write(cartridge, 0x8000, 0b10000);// 4Kb CHR mode
+        write(cartridge, 0xA000, 1);      // select bank 1 for the $0000 window
+
+        cartridge.chr_write(0x0000, 0xFF);
+        CHECK(std::ranges::equal(cartridge.chr_row(0x0000), std::array{1, 1, 1, 1, 1, 1, 1, 1}));
+
+        write(cartridge, 0xA000, 0);
+        CHECK(std::ranges::equal(cartridge.chr_row(0x0000), std::array{0, 0, 0, 0, 0, 0, 0, 0}));
+    }
 }
 
 TEST_CASE("Mapper MMC1 with CHR ROM ignores writes") {
@@ -210,4 +267,33 @@ TEST_CASE("Mapper MMC1 with CHR ROM ignores writes") {
     cartridge.chr_write(0x0000, 0x99);
 
     CHECK(cartridge.chr_read(0x0000) == 0x11);// unchanged - real ROM boards ignore writes
-}
\ No newline at end of file
+    CHECK(std::ranges::equal(cartridge.chr_row(0x0000), std::array{0, 0, 0, 1, 0, 0, 0, 1}));
+}
+TEST_CASE("Mapper MMC1 serial port timing") {
+    auto prg = std::vector<nes::membank<16_Kb>>{{}, {}};
+    auto chr = std::vector<nes::membank<4_Kb>>{{}, {}};
+
+    auto cartridge = nes::mmc1{prg, chr};
+
+    auto write_at = [&cartridge](std::uint64_t cycle, std::uint8_t value) {
+        cartridge.set_write_cycle(cycle);
+        cartridge.write(0x8000, value);
+    };
+
+    SECTION("Writes a cycle or more apart all count") {
+        for (auto bit = 0; bit < 5; ++bit)
+            write_at(static_cast<std::uint64_t>(bit * 2), static_cast<std::uint8_t>(0b00010 >> bit));
+
+        CHECK(cartridge.mirroring() == nes::name_table_mirroring::vertical);
+    }
+
+    SECTION("A write on the cycle right after another is ignored") {
+        // As a read-modify-write makes them: the old value, then the new
+        for (auto bit = 0; bit < 5; ++bit) {
+            write_at(static_cast<std::uint64_t>(bit * 10), static_cast<std::uint8_t>(0b00010 >> bit));
+            write_at(static_cast<std::uint64_t>(bit * 10 + 1), 1);
+        }
+
+        CHECK(cartridge.mirroring() == nes::name_table_mirroring::vertical);
+    }
+}
@@ -44,6 +44,13 @@ TEST_CASE("scanline cycles") {
         CHECK(scan.cycle() == 0);
     }
 
+    SECTION("several dots at once") {
+        tick(scan, 341 + 2);
+        scan.advance(256);
+        CHECK(scan.line() == 0);
+        CHECK(scan.cycle() == 258);
+    }
+
     SECTION("next frame") {
         tick(scan, 341 * 262);
         CHECK(scan.line() == -1);
@@ -71,4 +78,21 @@ TEST_CASE("scanline cycles") {
         tick(scan, 341 * 262);
         CHECK_FALSE(scan.is_odd_frame());
     }
+
+    SECTION("frame length") {
+        CHECK(scan.frame_dots() == 341 * 262);
+    }
+
+    SECTION("dots until a position") {
+        CHECK(scan.dots_until(-1, 0) == 0);
+        CHECK(scan.dots_until(-1, 1) == 1);
+        CHECK(scan.dots_until(241, 1) == 341 * 242 + 1);
+
+        tick(scan, 341 * 242 + 1);
+        CHECK(scan.dots_until(241, 1) == 0);
+        CHECK(scan.dots_until(-1, 1) == 341 * 20);
+
+        tick(scan);
+        CHECK(scan.dots_until(241, 1) == 341 * 262 - 1);
+    }
 }
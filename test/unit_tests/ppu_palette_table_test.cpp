@@ -1,6 +1,8 @@
 #include <libnes/ppu_palette_table.hpp>
 #include <catch2/catch_all.hpp>
 
+#include <random>
+
 TEST_CASE("palette address") {
     auto pt = nes::palette_table{nes::DEFAULT_COLORS};
 
@@ -33,4 +35,66 @@ TEST_CASE("palette address") {
 
         CHECK(pt.color_of(0, 2) == nes::DEFAULT_COLORS[0x0F]);
     }
-}
\ No newline at end of file
+
+    SECTION("a write to a mirrored entry shows through both") {
+        pt.write(0x10, 0x21);
+
+        CHECK(pt.color_of(0, 0) == nes::DEFAULT_COLORS[0x21]);
+        CHECK(pt.color_of(0, 4) == nes::DEFAULT_COLORS[0x21]);
+    }
+}
+
+TEST_CASE("palette colors under the mask") {
+    auto pt = nes::palette_table{nes::DEFAULT_COLORS};
+    pt.write(0x05, 0x16);
+
+    SECTION("greyscale keeps the brightness column") {
+        pt.set_mask(0x01);
+
+        CHECK(pt.color_of(1, 1) == nes::DEFAULT_COLORS[0x10]);
+    }
+
+    SECTION("colors written under the mask are resolved under it") {
+        pt.set_mask(0x01);
+        pt.write(0x06, 0x2A);
+
+        CHECK(pt.color_of(2, 1) == nes::DEFAULT_COLORS[0x20]);
+    }
+
+    SECTION("clearing the mask restores the colors") {
+        pt.set_mask(0xE1);
+        pt.set_mask(0x1E);// rendering bits only
+
+        CHECK(pt.color_of(1, 1) == nes::DEFAULT_COLORS[0x16]);
+    }
+
+    SECTION("emphasis dims the other channels") {
+        pt.write(0x05, 0x20);// white: F8 F8 F8
+        pt.set_mask(0x20);   // emphasize red
+
+        CHECK(pt.color_of(1, 1) == nes::color{0xF8, 0xBA, 0xBA});
+
+        pt.set_mask(0xE0);// all three dim everything
+
+        CHECK(pt.color_of(1, 1) == nes::color{0xBA, 0xBA, 0xBA});
+    }
+}
+
+TEST_CASE("palette colors of a row") {
+    auto pt = nes::palette_table{nes::DEFAULT_COLORS};
+    auto random = std::mt19937{5};
+
+    for (auto address = std::uint8_t{0}; address < 0x20; ++address)
+        pt.write(address, static_cast<std::uint8_t>(random() & 0x3F));
+
+    for (auto n = 0; n < 1000; ++n) {
+        auto pixels = std::array<std::uint8_t, 8>{};
+        for (auto& pixel: pixels)
+            pixel = static_cast<std::uint8_t>(random() & 0x03);
+        auto palette = static_cast<std::uint8_t>(random() & 0x07);
+
+        auto colors = pt.colors_of(pixels, palette);
+        for (auto i = 0; i < 8; ++i)
+            CHECK(colors[i] == pt.color_of(pixels[i], palette));
+    }
+}
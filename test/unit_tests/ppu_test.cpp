@@ -4,6 +4,8 @@
 #include <catch2/catch_all.hpp>
 
 #include "libnes/cartridge.hpp"
+#include "libnes/chr_tile_cache.hpp"
+#include <random>
 #include <ranges>
 #include <unordered_map>
 
@@ -12,9 +14,15 @@ using namespace nes::literals;
 namespace
 {
 
+// Which of its renderers the PPU runs; the PPU test case goes through both
+auto pipelined = false;
+
 void tick(auto& ppu, auto& screen, int times = 1) {
     for (auto i = 0; i < times; ++i) {
-        ppu.tick_old(screen);
+        if (pipelined)
+            ppu.tick(screen);
+        else
+            ppu.tick_old(screen);
     }
 }
 
@@ -40,6 +48,7 @@ struct test_screen {
 
 struct test_cartridge: nes::cartridge {
     nes::membank<8_Kb> cart_chr{};
+    mutable std::array<std::uint8_t, 8> row{};
     nes::name_table_mirroring cart_mirroring{nes::name_table_mirroring::vertical};
 
     test_cartridge() = default;
@@ -51,6 +60,12 @@ struct test_cartridge: nes::cartridge {
         return cart_chr[addr % 8_Kb];
     }
 
+    // Decoded on every call, so that tests can poke cart_chr
+    [[nodiscard]] auto chr_row(std::uint16_t addr) const noexcept -> std::span<const std::uint8_t, 8> override {
+        row = nes::decode_tile_row(cart_chr[addr % 8_Kb], cart_chr[(addr + 8) % 8_Kb]);
+        return row;
+    }
+
     [[nodiscard]] auto mirroring() const noexcept -> nes::name_table_mirroring override {
         return cart_mirroring;
     }
@@ -105,6 +120,8 @@ auto pattern_table(int index, input_type&& tile, args_t... args) {
 }// namespace
 
 TEST_CASE("PPU") {
+    pipelined = GENERATE(false, true);
+
     auto screen = test_screen{};
     auto ppu = nes::ppu{nes::DEFAULT_COLORS};
 
@@ -276,6 +293,14 @@ TEST_CASE("PPU") {
                 CHECK(screen.pixels.at(nes::point{0, 0}) == BLACK);
             }
 
+            SECTION("greyscale shows the backdrop's grey") {
+                write(0x2001, ppu, 0x01);// rendering disabled, greyscale
+
+                tick(ppu, screen, 242 * 341);// Wait one frame
+
+                CHECK(screen.pixels.at(nes::point{0, 0}) == WHITE);// $3F greyed is $30
+            }
+
             SECTION("background enabled but leftmost 8 pixels hidden") {
                 write(0x2001, ppu, 0x08);// show background, no leftmost-8 bit
 
@@ -572,4 +597,71 @@ TEST_CASE("PPU") {
             }
         }
     }
-}
\ No newline at end of file
+}
+
+// Drawing a visible line in one go leaves the same pixels, status and
+// scroll behind as drawing it a dot at a time
+TEST_CASE("PPU - whole scanlines") {
+    auto random = std::mt19937{7};
+    auto byte = [&random] { return static_cast<int>(random() & 0xFF); };
+
+    auto chr = nes::membank<8_Kb>{};
+    std::ranges::generate(chr, byte);
+    auto cartridge = test_cartridge{chr};
+
+    auto sprites = std::array<nes::sprite, 64>{};
+    sprites[0] = nes::sprite{.y = 40, .tile = 3, .attr = 0x40, .x = 4};
+    auto mempage = std::bit_cast<std::uint8_t*>(sprites.data());
+
+    auto set_up = [&](nes::ppu& ppu) {
+        ppu.load_cartridge(&cartridge);
+
+        auto fill = std::mt19937{11};
+        write(0x2006, ppu, 0x20, 0x00);
+        for (auto i = std::size_t{0}; i < 4_Kb; ++i)
+            write(0x2007, ppu, static_cast<int>(fill() & 0xFF));
+        write(0x2006, ppu, 0x3F, 0x00);
+        for (auto i = 0; i < 32; ++i)
+            write(0x2007, ppu, static_cast<int>(fill() & 0x3F));
+
+        ppu.dma_write(0x0000, [mempage](auto addr) { return mempage[addr]; });
+
+        write(0x2000, ppu, 0x11);// background from pattern table 1, nametable 1
+        write(0x2005, ppu, 13, 37);
+        write(0x2001, ppu, 0x18);// background and sprites, leftmost 8 pixels hidden
+    };
+
+    auto dot_ppu = nes::ppu{nes::DEFAULT_COLORS};
+    auto dot_screen = test_screen{};
+    set_up(dot_ppu);
+
+    auto line_ppu = nes::ppu{nes::DEFAULT_COLORS};
+    auto line_screen = test_screen{};
+    set_up(line_ppu);
+
+    auto run = [&](int dots) {
+        for (auto i = 0; i < dots; ++i)
+            dot_ppu.tick_old(dot_screen);
+        for (auto left = dots; left > 0;)
+            left -= line_ppu.run_old(line_screen, static_cast<std::uint64_t>(left));
+    };
+
+    SECTION("a frame of them") {
+        run(262 * 341);
+
+        CHECK((line_ppu.status & 0x40) != 0);
+    }
+
+    SECTION("a write halfway through a line") {
+        run(101 * 341 + 130);
+        write(0x2001, dot_ppu, 0x1E);
+        write(0x2001, line_ppu, 0x1E);
+        write(0x2005, dot_ppu, 200, 3);
+        write(0x2005, line_ppu, 200, 3);
+        run(161 * 341 - 130);
+    }
+
+    CHECK(line_screen.pixels == dot_screen.pixels);
+    CHECK(line_ppu.status == dot_ppu.status);
+    CHECK(line_ppu.scroll_.current.raw() == dot_ppu.scroll_.current.raw());
+}
@@ -4,10 +4,12 @@
 #include <string_view>
 #include <fstream>
 #include <algorithm>
+#include <array>
 #include <iomanip>
 #include <string>
 
 #include <libnes/cpu.hpp>
+#include <libnes/cpu_disassembler.hpp>
 #include <libnes/literals.hpp>
 
 using namespace std::string_literals;
@@ -63,6 +65,14 @@ auto access_type(auto at) {
     return at == grabbr::access_type::read ? "READ" : "WRITE";
 }
 
+// The three bytes from `pc` on, wrapping round the top of memory
+auto instruction_bytes(const std::vector<std::uint8_t>& mem, std::uint16_t pc) {
+    return std::array{
+        mem[pc],
+        mem[static_cast<std::uint16_t>(pc + 1)],
+        mem[static_cast<std::uint16_t>(pc + 2)]};
+}
+
 auto& print_data(auto& s, auto d) {
     return d.has_value()
         ? s << std::setw(2) <<  std::setfill('0') << static_cast<int>(d.value())
@@ -76,7 +86,12 @@ int main(int argc, char* argv[]) {
 
         bus.mem[0x2002] = 0x80;
 
+        auto instruction_pc = std::uint16_t{0};
+
         while(bus.cycle < 1000000) {
+            if (not cpu.is_executing())
+                instruction_pc = cpu.pc.value();
+
             bus.tick();
             cpu.tick();
 
@@ -86,7 +101,8 @@ int main(int argc, char* argv[]) {
                         << std::dec << bus.cycle << '\t'
                         << access_type(type) << '\t'
                         << '$' << std::hex << addr << '\t';
-                print_data(std::cout, data) << '\n';
+                print_data(std::cout, data) << '\t'
+                        << nes::disassemble(instruction_pc, instruction_bytes(bus.mem, instruction_pc)) << '\n';
                 bus.ppu_access = std::nullopt;
             }
         }
@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <libnes/cpu_disassembler.hpp>
+#include <libnes/cpu_opcodes.hpp>
+#include <libnes/cpu_trace.hpp>
+
+// A file mapped read-only, for the kernel to page in as it's read through
+// and drop behind: traces of any size take next to no memory
+class mapped_file
+{
+public:
+    explicit mapped_file(const std::string& filename) {
+        fd_ = ::open(filename.c_str(), O_RDONLY);
+        if (fd_ < 0)
+            throw std::runtime_error("can't open " + filename);
+
+        struct stat st{};
+        if (::fstat(fd_, &st) != 0) {
+            ::close(fd_);
+            throw std::runtime_error("can't stat " + filename);
+        }
+
+        size_ = static_cast<std::size_t>(st.st_size);
+        if (size_ == 0)
+            return;
+
+        auto data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd_);
+            throw std::runtime_error("can't map " + filename);
+        }
+
+        ::madvise(data, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(data);
+    }
+
+    ~mapped_file() {
+        if (data_ != nullptr)
+            ::munmap(const_cast<char*>(data_), size_);
+        ::close(fd_);
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    [[nodiscard]] auto bytes() const noexcept { return std::span{data_, size_}; }
+
+private:
+    int fd_{-1};
+    const char* data_{nullptr};
+    std::size_t size_{0};
+};
+
+// A record of either kind of trace, and where it was found
+struct entry {
+    nes::trace_record record;
+    bool has_cycle;
+    std::size_t position;// the record's number in a binary trace, from 0, or the line's in a text log, from 1
+};
+
+// Reads a binary trace, as nes::trace_recorder writes it, or a text log
+// like nestest.log, one record at a time. Lines of a log that don't start
+// with an address are skipped; "CYC:" is optional
+class trace_reader
+{
+public:
+    explicit trace_reader(const std::string& filename)
+        : file_{filename}
+        , bytes_{file_.bytes()} {
+        // Text has no NULs, and every record has some
+        auto head = bytes_.first(std::min(bytes_.size(), sizeof(nes::trace_record)));
+        binary_ = std::ranges::find(head, '\0') != head.end();
+    }
+
+    [[nodiscard]] auto is_binary() const noexcept { return binary_; }
+
+    auto next() -> std::optional<entry> {
+        return binary_ ? next_record() : next_line();
+    }
+
+private:
+    auto next_record() -> std::optional<entry> {
+        if (bytes_.size() - offset_ < sizeof(nes::trace_record))
+            return std::nullopt;
+
+        auto e = entry{{}, true, position_++};
+        std::memcpy(&e.record, bytes_.data() + offset_, sizeof(nes::trace_record));
+        offset_ += sizeof(nes::trace_record);
+        return e;
+    }
+
+    auto next_line() -> std::optional<entry> {
+        while (offset_ < bytes_.size()) {
+            auto rest = std::string_view{bytes_.data() + offset_, bytes_.size() - offset_};
+            auto line = rest.substr(0, rest.find('\n'));
+            offset_ += line.size() + 1;
+            ++position_;
+
+            if (auto e = parse(line); e.has_value())
+                return e;
+        }
+        return std::nullopt;
+    }
+
+    [[nodiscard]] auto parse(std::string_view line) const -> std::optional<entry> {
+        auto e = entry{{}, false, position_};
+
+        auto pc = hex(line, 0, 4);
+        if (not pc.has_value() or line.size() < 16)
+            return std::nullopt;
+        e.record.pc = static_cast<std::uint16_t>(*pc);
+
+        for (auto i = std::size_t{0}; i < 3; ++i) {
+            if (auto byte = hex(line, 6 + 3 * i, 2); byte.has_value())
+                e.record.bytes[i] = static_cast<std::uint8_t>(*byte);
+        }
+
+        // One pass over the columns from A on, PPU and CYC padded as they may be
+        auto at = line.size() > 50 and line.substr(47, 3) == " A:" ? std::size_t{47} : line.find(" A:", 16);
+        if (at == std::string_view::npos)
+            return std::nullopt;
+
+        auto seen = 0;
+        for (auto i = at + 1; i < line.size();) {
+            auto colon = line.find(':', i);
+            if (colon == std::string_view::npos)
+                break;
+
+            auto name = line.substr(i, colon - i);
+            auto base = name == "CYC" or name == "PPU" ? 10 : 16;
+            auto value = std::uint64_t{0};
+
+            i = colon + 1;
+            while (i < line.size() and line[i] == ' ')
+                ++i;
+            for (; i < line.size() and digit(line[i], base) >= 0; ++i)
+                value = value * static_cast<std::uint64_t>(base) + static_cast<std::uint64_t>(digit(line[i], base));
+
+            auto store = [&](std::uint8_t& r, int bit) {
+                r = static_cast<std::uint8_t>(value);
+                seen |= bit;
+            };
+
+            if (name == "A")
+                store(e.record.a, 1);
+            else if (name == "X")
+                store(e.record.x, 2);
+            else if (name == "Y")
+                store(e.record.y, 4);
+            else if (name == "P")
+                store(e.record.p, 8);
+            else if (name == "SP")
+                store(e.record.s, 16);
+            else if (name == "CYC") {
+                e.record.cycle = value;
+                e.has_cycle = true;
+            }
+
+            // On to the next column's name: past the PPU's dot and the padding
+            while (i < line.size() and (line[i] < 'A' or line[i] > 'Z'))
+                ++i;
+        }
+
+        return seen == 31 ? std::optional{e} : std::nullopt;
+    }
+
+    [[nodiscard]] static auto hex(std::string_view line, std::size_t at, std::size_t length) -> std::optional<std::uint64_t> {
+        if (line.size() < at + length)
+            return std::nullopt;
+
+        auto value = std::uint64_t{0};
+        for (auto i = at; i < at + length; ++i) {
+            auto d = digit(line[i], 16);
+            if (d < 0)
+                return std::nullopt;
+            value = value * 16 + static_cast<std::uint64_t>(d);
+        }
+        return value;
+    }
+
+    [[nodiscard]] static constexpr auto digit(char c, int base) noexcept -> int {
+        if (c >= '0' and c <= '9')
+            return c - '0';
+        if (base == 16 and c >= 'A' and c <= 'F')
+            return c - 'A' + 10;
+        if (base == 16 and c >= 'a' and c <= 'f')
+            return c - 'a' + 10;
+        return -1;
+    }
+
+    mapped_file file_;
+    std::span<const char> bytes_;
+    bool binary_{false};
+    std::size_t offset_{0};
+    std::size_t position_{0};
+};
+
+// What differs between the two records: the instruction's own bytes and
+// the registers, and the cycles gone by since the first record when both
+// traces count them
+auto differences(const entry& ours, const entry& reference, std::uint64_t ours_start, std::uint64_t reference_start) -> std::string {
+    auto fields = std::string{};
+    auto differ = [&fields](bool different, std::string_view name) {
+        if (different)
+            fields += fields.empty() ? name : std::format(", {}", name);
+    };
+
+    const auto& o = ours.record;
+    const auto& r = reference.record;
+    auto length = static_cast<std::size_t>(std::clamp(nes::OPCODES[r.bytes[0]].length, 1, 3));
+
+    differ(o.pc != r.pc, "PC");
+    differ(not std::ranges::equal(std::span{o.bytes}.first(length), std::span{r.bytes}.first(length)), "bytes");
+    differ(o.a != r.a, "A");
+    differ(o.x != r.x, "X");
+    differ(o.y != r.y, "Y");
+    differ(o.p != r.p, "P");
+    differ(o.s != r.s, "SP");
+    differ(ours.has_cycle and reference.has_cycle and o.cycle - ours_start != r.cycle - reference_start, "CYC");
+
+    return fields;
+}
+
+// The record as a log line, its cycle counted from the first record's
+auto format(const entry& e, std::uint64_t start) -> std::string {
+    auto record = e.record;
+    record.cycle -= start;
+
+    auto line = nes::trace_line(record, record.bytes);
+    return e.has_cycle ? line : line.substr(0, line.rfind(" CYC:"));
+}
+
+int main(int argc, char* argv[]) {
+    auto arguments = std::vector<std::string>(argv + 1, argv + argc);
+    auto context = std::size_t{5};
+
+    if (arguments.size() == 4 and arguments[0] == "-c") {
+        context = std::stoul(arguments[1]);
+        arguments.erase(arguments.begin(), arguments.begin() + 2);
+    }
+
+    if (arguments.size() != 2) {
+        std::cerr << "usage: " << argv[0] << " [-c <context lines>] <our trace> <reference trace>\n"
+                  << "Traces are binary, as nes::trace_recorder writes them, or text, as nestest.log has them\n";
+        return 2;
+    }
+
+    try {
+        auto ours = trace_reader{arguments[0]};
+        auto reference = trace_reader{arguments[1]};
+
+        // The last instructions alike, oldest first from `next_history`
+        auto history = std::vector<entry>(context);
+        auto next_history = std::size_t{0};
+        auto ours_start = std::uint64_t{0};
+        auto reference_start = std::uint64_t{0};
+        auto where = [](const trace_reader& t, const entry& e) {
+            return std::format("{} {}", t.is_binary() ? "record" : "line", e.position);
+        };
+
+        for (auto count = std::size_t{0};; ++count) {
+            auto o = ours.next();
+            auto r = reference.next();
+
+            if (not o.has_value() and not r.has_value()) {
+                std::cout << std::format("{} instructions, no divergence\n", count);
+                return 0;
+            }
+
+            if (count == 0 and o.has_value() and r.has_value()) {
+                ours_start = o->record.cycle;
+                reference_start = r->record.cycle;
+            }
+
+            auto diverged = std::string{};
+            if (not o.has_value() or not r.has_value())
+                diverged = std::format("{} trace ends first", o.has_value() ? "the reference" : "our");
+            else
+                diverged = differences(*o, *r, ours_start, reference_start);
+
+            if (diverged.empty()) {
+                if (context > 0) {
+                    history[next_history] = *o;
+                    next_history = next_history + 1 == context ? 0 : next_history + 1;
+                }
+                continue;
+            }
+
+            std::cout << std::format("Diverged at instruction {}: {}\n", count + 1, diverged);
+            for (auto i = std::max(count, context) - context; i < count; ++i)
+                std::cout << "   " << format(history[(next_history + i + context - count) % context], ours_start) << '\n';
+
+            if (o.has_value())
+                std::cout << "<  " << format(*o, ours_start) << "  (" << where(ours, *o) << ")\n";
+            if (r.has_value())
+                std::cout << ">  " << format(*r, reference_start) << "  (" << where(reference, *r) << ")\n";
+
+            return 1;
+        }
+    }
+    catch (const std::exception& ex) {
+        std::cerr << ex.what() << '\n';
+        return 2;
+    }
+}
@@ -0,0 +1,27 @@
+#include <fstream>
+#include <iostream>
+
+#include <libnes/cpu_trace.hpp>
+
+// Rewrites a binary trace, as nes::trace_recorder writes it, as nestest.log
+// has it: trace_to_log <trace file> [<log file>], to stdout if no log file
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <trace file> [<log file>]" << std::endl;
+        return 1;
+    }
+
+    auto trace = std::ifstream{argv[1], std::ifstream::binary};
+    if (not trace) {
+        std::cerr << "can't open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    if (argc < 3) {
+        nes::write_nestest_log(trace, std::cout);
+        return 0;
+    }
+
+    auto log = std::ofstream{argv[2]};
+    nes::write_nestest_log(trace, log);
+}